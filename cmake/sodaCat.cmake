@@ -141,7 +141,13 @@ endfunction()
 #                 which uses it to qualify per-instance integration types.
 #   model_path  - Path to model file relative to SODACAT_LOCAL_DIR (e.g., ST/H757/H757)
 #   suffix      - File name suffix of generated header file
+# Options:
+#   ID_TYPE <type> - Signal ID type of a clock-tree model (uint8_t or uint16_t)
+#                 instead of the narrowest that fits, e.g. to test the wide
+#                 tables on a small tree; not passed on to dependencies
 function(generate_header target language namespace model_path suffix)
+    cmake_parse_arguments(PARSE_ARGV 5 _arg "" "ID_TYPE" "")
+
     # Extract model name from path (last component)
     get_filename_component(model "${model_path}" NAME)
 
@@ -255,11 +261,21 @@ function(generate_header target language namespace model_path suffix)
         set(_python_ns "${_ns_yaml}")
     endif()
 
-    # The generator produces both a .hpp header and a .cppm module wrapper
+    # The generator produces both a .hpp header and a .cppm module wrapper,
+    # and for a clock tree (a model with a top-level `signals:` key) also a
+    # size report, collected for clocktree_footprint_report().
     get_filename_component(model_stem "${model}${suffix}" NAME_WE)
+    set(_extra_outputs)
+    file(STRINGS "${model_file}" _signals_key REGEX "^signals:" LIMIT_COUNT 1)
+    if(_signals_key)
+        set(_extra_outputs "${_out_dir}/${model_stem}.footprint.json")
+        set_property(GLOBAL APPEND PROPERTY _SODACAT_CLOCKTREE_FOOTPRINTS ${_extra_outputs})
+        set_property(GLOBAL APPEND PROPERTY _SODACAT_CLOCKTREE_TARGETS ${target})
+    endif()
     add_custom_command(OUTPUT "${_out_dir}/${model}${suffix}"
                               "${_out_dir}/${model_stem}.cppm"
-        COMMAND ${Python3_EXECUTABLE} "${generator_script}" "${model_file}" "${_python_ns}" ${model} ${suffix}
+                              ${_extra_outputs}
+        COMMAND ${Python3_EXECUTABLE} "${generator_script}" "${model_file}" "${_python_ns}" ${model} ${suffix} ${_arg_ID_TYPE}
         WORKING_DIRECTORY "${_out_dir}"
         MAIN_DEPENDENCY "${model_file}"
         DEPENDS ${generator_scripts}
@@ -274,6 +290,39 @@ function(generate_header target language namespace model_path suffix)
     )
 endfunction()
 
+# Aggregate the size reports of all clock trees generated so far into
+# ${CMAKE_CURRENT_BINARY_DIR}/<target>.json, built by a custom target.  Call it
+# after the generate_header() calls, from the same directory.
+# Parameters:
+#   target      - Name of the custom target to create
+#   language    - Generator language providing clocktree_footprint.py
+function(clocktree_footprint_report target language)
+    string(TOUPPER "${language}" lang_upper)
+    set(generator_dir "${SODACAT_GENERATOR_${lang_upper}}")
+    if(NOT generator_dir)
+        message(FATAL_ERROR "Generator '${language}' not configured. Call sodacat_fetch_generator(${language}) first.")
+    endif()
+    get_property(_reports GLOBAL PROPERTY _SODACAT_CLOCKTREE_FOOTPRINTS)
+    get_property(_targets GLOBAL PROPERTY _SODACAT_CLOCKTREE_TARGETS)
+    if(NOT _reports)
+        message(WARNING "No clock trees generated, ${target} reports nothing")
+    endif()
+    set(_output "${CMAKE_CURRENT_BINARY_DIR}/${target}.json")
+    add_custom_command(OUTPUT "${_output}"
+        COMMAND ${Python3_EXECUTABLE} "${generator_dir}/clocktree_footprint.py" "${_output}" ${_reports}
+        DEPENDS ${_reports} "${generator_dir}/clocktree_footprint.py"
+        COMMENT "Aggregating clock-tree footprint reports"
+        VERBATIM
+    )
+    add_custom_target(${target} DEPENDS "${_output}")
+    # The reports are outputs of the header generation commands attached to
+    # these targets, so build those first rather than running them twice.
+    list(REMOVE_DUPLICATES _targets)
+    if(_targets)
+        add_dependencies(${target} ${_targets})
+    endif()
+endfunction()
+
 # Pre-compile C++ standard library headers as header units.
 # This is required when using -fmodules-ts with GCC, because GCC does not
 # properly deduplicate standard library declarations between modules and
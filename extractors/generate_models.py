@@ -91,6 +91,8 @@ def load_family_config(family_code, config_file):
         sf = {'chips': list(info['chips'])}
         if info.get('clocktree') is not None:
             sf['clocktree'] = info['clocktree']
+        if info.get('atomic_aliases') is not None:
+            sf['atomic_aliases'] = dict(info['atomic_aliases'])
         families[name] = sf
 
     blocks_config = {}
@@ -1993,6 +1995,16 @@ def main():
                 families.get(subfamily_name, {}).get('clocktree') or clocktree)
             if chip_clocktree:
                 chip_model['clocktree'] = chip_clocktree
+            # Register aliases where a write XORs, sets or clears the written
+            # bits (RP2040/RP2350), copied from the subfamily config.
+            aliases = families.get(subfamily_name, {}).get('atomic_aliases')
+            if aliases:
+                chip_model['atomicAliases'] = {
+                    'xor': int(aliases['xor']),
+                    'set': int(aliases['set']),
+                    'clear': int(aliases['clear']),
+                    'exclude': sorted(aliases.get('exclude') or []),
+                }
             chip_model.update({
                 'cpu': device_meta.get('cpu', {}),
                 'interruptOffset': interrupt_offset,
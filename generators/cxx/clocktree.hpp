@@ -17,68 +17,133 @@
 
 #ifndef EXPORT
 #include <cstdint>
+#include <initializer_list>
 #include <span>
+#include <type_traits>
 #define EXPORT
 #endif
 
 EXPORT namespace clocktree {
 
-class ClockTreeBase;
+// The tables are templated on the signal ID type `Id`: uint8_t for trees of
+// up to 256 signals, uint16_t for larger ones. The generator picks the
+// narrowest type that fits, so small trees keep their compact tables.
 
-/// Frequency computation function signature.
+template<typename Id> class ClockTreeBase;
+template<typename Id> struct EvalContext;
+
+// Every element derives its output from at most one of its inputs, so an
+// element type is described by two functions: one picks the input signal
+// the output currently depends on, the other computes the output frequency
+// from that input's frequency. The evaluator calls them in turn, without
+// the frequency functions ever calling back into the tree: the whole-tree
+// sweep through the type table, the single-signal queries directly, by the
+// element's Kind.
+
+/// Input selection function signature.
 /// @param desc     Pointer to the element's descriptor (type-specific)
 /// @param inputs   Pointer into the input pool (signal IDs of this element's inputs)
-/// @param tree     The clock tree instance (for recursive getFrequency and mutable state)
-using FreqFn = uint32_t(*)(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+/// @param ctx      Evaluation context (register snapshot, tables and mutable state)
+/// @return         Signal ID of the input the output depends on, or 0 if it
+///                 doesn't depend on any (sources, disabled gates)
+template<typename Id>
+using InputFn = Id(*)(void const* desc, Id const* inputs, EvalContext<Id> const& ctx);
+
+/// Frequency computation function signature.
+/// @param desc     Pointer to the element's descriptor (type-specific)
+/// @param in_freq  Frequency of the input chosen by the InputFn (0 for none)
+/// @param ctx      Evaluation context (register snapshot, tables and mutable state)
+template<typename Id>
+using FreqFn = uint32_t(*)(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
+
+/// Kind of a standard element type, for code that needs to know the
+/// descriptor type at compile time.
+enum class Kind : uint8_t {
+    Gate, GateInv, Passthrough, GenFixed, GenExternal,
+    TableDiv, LinearDiv, FixedDiv, FracDiv, Mux, Pll,
+};
 
 /// Block type descriptor — one entry per distinct element type in the type table.
-struct BlockType {
-    FreqFn       freq;          ///< Frequency computation function
+template<typename Id> struct BlockType {
+    InputFn<Id>  input;         ///< Input selection function
+    FreqFn<Id>   freq;          ///< Frequency computation function
     void const*  descriptors;   ///< Pointer to constexpr descriptor array
     uint8_t      desc_size;     ///< sizeof(one descriptor), for pointer arithmetic
+    Kind         kind;          ///< Element kind, selects the descriptor type
 };
 
-/// Signal-to-element mapping — 4 bytes per signal.
-struct Signal {
+// The sizes below are those of a 32-bit target, as assumed by target_sizeof
+// in generate_clocktree_header.py for the footprint report.
+static_assert(sizeof(void*) != 4 || sizeof(BlockType<uint8_t>) == 16);
+
+/// Signal-to-element mapping — 4 bytes per signal (6 with 16-bit IDs).
+template<typename Id> struct Signal {
     uint8_t  type;          ///< Index into the type table (0 = undriven)
-    uint8_t  desc_index;    ///< Index into that type's descriptor array
+    Id       desc_index;    ///< Index into that type's descriptor array
     uint16_t input_offset;  ///< Offset into the input pool
 };
 
+/// Register bits read by the element driving a signal — one entry per
+/// element and register word, sorted by word offset.
+template<typename Id> struct FieldUse {
+    uint32_t word_offset;   ///< Word offset from register_base
+    uint32_t mask;          ///< Bits of that word read by the element
+    Id       signal;        ///< Signal driven by the element
+};
+static_assert(sizeof(void*) != 4 || sizeof(FieldUse<uint8_t>) == 12);
+
 // ---------------------------------------------------------------------------
-// Helpers for reading MMIO bitfields from packed addresses
+// Register access backends
+//
+// A backend supplies `uint32_t read(uintptr_t addr) const` and is selected
+// with the second template parameter of ClockTree.
 // ---------------------------------------------------------------------------
 
-/// Base address of the Cortex-M peripheral region.
-/// Word offsets in BitAddr/FieldAddr are relative to this.
-inline constexpr uintptr_t periph_base = 0x40000000;
+/// Default backend: reads the memory-mapped registers of the running chip.
+struct MmioBackend {
+    static uint32_t read(uintptr_t addr) {
+        return *reinterpret_cast<volatile uint32_t const*>(addr);
+    }
+};
 
-/// Read a single bit from an MMIO register.
-/// @param word_offset  Register word offset from periph_base
-/// @param bit          Bit position within the 32-bit register
-inline uint32_t read_bit(uint32_t word_offset, uint32_t bit) {
-    auto reg = *reinterpret_cast<volatile uint32_t const*>(periph_base + (uintptr_t(word_offset) << 2));
-    return (reg >> bit) & 1;
-}
+/** Host backend: reads from a register image in ordinary memory.
+ *
+ * The image consists of one or more regions, each a block of consecutive
+ * 32-bit registers starting at the address the registers have on the chip.
+ * Addresses outside all regions read as 0. The regions, and the memory
+ * they refer to, are owned by the caller and must outlive the clock tree;
+ * changes to that memory are seen by the next query.
+ */
+class RegisterImage {
+public:
+    struct Region {
+        uintptr_t                 addr;     ///< Chip address of words[0]
+        std::span<uint32_t const> words;    ///< Register contents
+    };
 
-/// Read a multi-bit field from an MMIO register.
-/// @param word_offset  Register word offset from periph_base
-/// @param bit          Bit position of the LSB
-/// @param width        Field width in bits
-inline uint32_t read_field(uint32_t word_offset, uint32_t bit, uint32_t width) {
-    auto reg = *reinterpret_cast<volatile uint32_t const*>(periph_base + (uintptr_t(word_offset) << 2));
-    return (reg >> bit) & ((1u << width) - 1);
-}
+    constexpr RegisterImage(std::span<Region const> regions) : regions_(regions) {}
+
+    constexpr uint32_t read(uintptr_t addr) const {
+        for (auto& r : regions_)
+            if (addr >= r.addr && (addr - r.addr) / 4 < r.words.size())
+                return r.words[(addr - r.addr) / 4];
+        return 0;
+    }
+
+private:
+    std::span<Region const> regions_;
+};
 
 // ---------------------------------------------------------------------------
 // Packed bit address — fits a peripheral register bit in 4 bytes.
-// Covers the Cortex-M peripheral range 0x40000000–0x5FFFFFFF.
-// Word offsets are relative to 0x40000000, so 27 bits cover 512 MB.
+// Word offsets are relative to the register_base of the generated Clocks
+// struct, so 27 bits cover a 512 MB window, e.g. 0x40000000–0x5FFFFFFF on
+// Cortex-M or 0x50000000–0x6FFFFFFF on the ESP32-P4.
 // ---------------------------------------------------------------------------
 
 /// Packed register bit address (4 bytes).
 struct BitAddr {
-    uint32_t word_offset : 27;  ///< Word offset from periph_base ((byte_addr - 0x40000000) >> 2)
+    uint32_t word_offset : 27;  ///< Word offset from register_base ((byte_addr - register_base) >> 2)
     uint32_t bit         : 5;   ///< Bit position within the register
 };
 
@@ -89,6 +154,88 @@ struct FieldAddr {
     uint8_t  width;             ///< Field width in bits
 };
 
+// ---------------------------------------------------------------------------
+// Evaluation context
+// ---------------------------------------------------------------------------
+
+/** Register words read during one query.
+ *
+ * Every register word is loaded from the hardware at most once per query, and
+ * all fields in it are decoded from that one value. This saves repeated reads
+ * when a mux selector, divider and PLL factor share a register, and gives the
+ * query a consistent view even if another core reprograms the clock tree
+ * concurrently. Once the buffer is full, further words are read directly.
+ */
+struct Snapshot {
+    struct Entry {
+        uint32_t word_offset;
+        uint32_t value;
+    };
+    /// Reads the register at addr through the tree's backend.
+    using Loader = uint32_t(*)(void const* backend, uintptr_t addr);
+
+    Entry*      entries;
+    uint16_t    capacity;
+    uintptr_t   base;       ///< Address of word offset 0
+    Loader      load;
+    void const* backend;
+    uint16_t    count = 0;
+
+    /// Contents of the register at word_offset, loaded on first use.
+    uint32_t word(uint32_t word_offset) {
+        for (uint16_t i = 0; i < count; ++i)
+            if (entries[i].word_offset == word_offset)
+                return entries[i].value;
+        uint32_t value = load(backend, base + (uintptr_t(word_offset) << 2));
+        if (count < capacity)
+            entries[count++] = {word_offset, value};
+        return value;
+    }
+};
+
+/// Snapshot with its own storage for N register words.
+template<size_t N> struct SnapshotBuffer : Snapshot {
+    constexpr SnapshotBuffer(uintptr_t base, Loader load, void const* backend)
+        : Snapshot{storage_, N, base, load, backend} {}
+    SnapshotBuffer(SnapshotBuffer const&) = delete;
+    SnapshotBuffer& operator=(SnapshotBuffer const&) = delete;
+private:
+    Entry storage_[N];
+};
+
+/// Per-query evaluation context passed to the frequency functions.
+template<typename Id> struct EvalContext {
+    ClockTreeBase<Id> const& tree;  ///< Tree being evaluated (value tables, state)
+    Snapshot&            regs;      ///< Register words read by this query
+
+    /// Read a single register bit.
+    uint32_t bit(BitAddr a) const {
+        return (regs.word(a.word_offset) >> a.bit) & 1;
+    }
+
+    /// Read a multi-bit register field.
+    uint32_t field(FieldAddr a) const {
+        return (regs.word(a.word_offset) >> a.bit) & ((1u << a.width) - 1);
+    }
+};
+
+/// Context of a compile-time specialized query: reads each register field
+/// straight from the backend, without a snapshot.
+template<typename Id, uintptr_t Base, typename Backend> struct DirectContext {
+    ClockTreeBase<Id> const& tree;  ///< Tree being evaluated (value tables, state)
+    Backend const&       backend;   ///< Register access backend
+
+    /// Read a single register bit.
+    constexpr uint32_t bit(BitAddr a) const {
+        return (backend.read(Base + (uintptr_t(a.word_offset) << 2)) >> a.bit) & 1;
+    }
+
+    /// Read a multi-bit register field.
+    constexpr uint32_t field(FieldAddr a) const {
+        return (backend.read(Base + (uintptr_t(a.word_offset) << 2)) >> a.bit) & ((1u << a.width) - 1);
+    }
+};
+
 // ---------------------------------------------------------------------------
 // Standard descriptor types
 // ---------------------------------------------------------------------------
@@ -97,6 +244,7 @@ struct FieldAddr {
 struct GateDesc {
     BitAddr addr;
 };
+static_assert(sizeof(void*) != 4 || sizeof(GateDesc) == 4);
 
 /// Inverted gate: passes input through when enable bit is clear (4 bytes).
 /// Uses the same struct as GateDesc but a different frequency function.
@@ -118,6 +266,7 @@ struct GenFixedDesc {
     uint32_t frequency;         ///< Nominal frequency in Hz
     Polarity polarity;          ///< Enable polarity
 };
+static_assert(sizeof(void*) != 4 || sizeof(GenFixedDesc) == 12);
 
 /// Generator with runtime-configurable frequency, e.g. external oscillator (8 bytes).
 struct GenExternalDesc {
@@ -125,30 +274,48 @@ struct GenExternalDesc {
     uint8_t  state_slot;        ///< Index into the mutable state[] array
     Polarity polarity;          ///< Enable polarity
 };
+static_assert(sizeof(void*) != 4 || sizeof(GenExternalDesc) == 8);
 
-/// Divider with table-based divisor lookup (8 bytes).
+/// Divider with table-based divisor lookup (12 bytes).
 struct TableDivDesc {
     FieldAddr field;            ///< Register field selecting the divisor
     uint8_t   table_offset;     ///< Offset into shared value_tables pool
     uint8_t   table_size;       ///< Number of entries in the table
 };
+static_assert(sizeof(void*) != 4 || sizeof(TableDivDesc) == 12);
 
-/// Divider with linear divisor: divisor = raw_field + offset (6 bytes).
+/// Divider with linear divisor: divisor = raw_field + offset (12 bytes).
 struct LinearDivDesc {
     FieldAddr field;
     uint8_t   offset;           ///< Added to raw field value
 };
+static_assert(sizeof(void*) != 4 || sizeof(LinearDivDesc) == 12);
 
 /// Fixed divider: always divides by a constant (2 bytes).
 struct FixedDivDesc {
     uint16_t divisor;
 };
+static_assert(sizeof(void*) != 4 || sizeof(FixedDivDesc) == 2);
+
+/// Fractional divider (20 bytes). With `frac_bits`, divisor = factor +
+/// fraction / 2^frac_bits from an integer and a fraction field (INT/FRAC),
+/// where INT = 0 divides by 2^16 as on the RP2040 and RP2350; without,
+/// divisor = base + factor / (denominator + offset).
+struct FracDivDesc {
+    FieldAddr factor;           ///< Integer part, or numerator of the ratio
+    FieldAddr denominator;      ///< Fraction, or denominator of the ratio
+    uint8_t   offset;           ///< Added to raw denominator
+    uint8_t   frac_bits;        ///< Width of the fraction, 0 for a ratio
+    uint8_t   base;             ///< Added to the ratio
+};
+static_assert(sizeof(void*) != 4 || sizeof(FracDivDesc) == 20);
 
-/// Multiplexer: selects one of N input signals (6 bytes).
+/// Multiplexer: selects one of N input signals (12 bytes).
 struct MuxDesc {
     FieldAddr field;            ///< Register field containing selector value
     uint8_t   input_count;      ///< Number of selectable inputs
 };
+static_assert(sizeof(void*) != 4 || sizeof(MuxDesc) == 12);
 
 /// PLL: output = input * (fb_int + fb_frac / 2^frac_bits) / post_div.
 struct PllDesc {
@@ -159,40 +326,195 @@ struct PllDesc {
     FieldAddr post_div;         ///< Post-divider, width=0 means unused (factor = 1)
     uint8_t   post_div_offset;  ///< Added to raw value (typically 1)
 };
+static_assert(sizeof(void*) != 4 || sizeof(PllDesc) == 36);
+
+// ---------------------------------------------------------------------------
+// PLL solver
+// ---------------------------------------------------------------------------
+
+/// Inclusive range of a factor or a frequency.
+struct Range {
+    uint32_t min;
+    uint32_t max;
+};
+
+/** A PLL with its reference divider and one post-divider, as generated from
+ * the clock-tree model for the solver.
+ *
+ * The post-divider is either the PLL's own or a linear divider fed by the PLL
+ * output; in the latter case `pll.post_div` refers to that divider's field.
+ * Absent dividers have a field width of 0 and the factor range {1, 1}.
+ * Factor ranges are raw field values plus offset, from the fields'
+ * `value_range`; frequency limits come from the signals' `min`/`max` and the
+ * PLL's `vco_limits`.
+ */
+template<typename Id> struct PllPath {
+    Id            input;        ///< Signal feeding the reference divider
+    Id            output;       ///< Signal set by the path
+    LinearDivDesc ref_div;      ///< Reference divider
+    PllDesc       pll;          ///< Feedback factors and post-divider
+    Range         ref_div_range;
+    Range         fb_int_range;
+    Range         fb_frac_range;  ///< Raw fraction values, {0, 0} without fraction
+    Range         post_div_range;
+    Range         ref_freq;     ///< PLL input (reference) frequency
+    Range         vco_freq;     ///< VCO frequency
+    Range         out_freq;     ///< Output frequency
+};
+static_assert(sizeof(void*) != 4 || sizeof(PllPath<uint8_t>) == 108);
+
+/// Raw register field values found by the solver.
+struct PllSettings {
+    uint32_t ref_div;           ///< Reference divider field
+    uint32_t fb_int;            ///< Feedback integer field
+    uint32_t fb_frac;           ///< Feedback fraction field
+    uint32_t post_div;          ///< Post-divider field
+    uint32_t frequency;         ///< Resulting output frequency, 0 if no setting meets the limits
+};
+
+/// Find the settings of a PLL path that bring the output closest to `target`
+/// for the input frequency `in_freq`.
+template<typename Id>
+constexpr PllSettings solve_pll(PllPath<Id> const& p, uint32_t in_freq, uint32_t target);
+
+// ---------------------------------------------------------------------------
+// Frequency representation
+// ---------------------------------------------------------------------------
+
+/** Precision policies of ClockTree: how frequencies are carried from element
+ * to element. `from` turns a generator's Hz into the representation, `div`
+ * and `scale` do the divider and PLL arithmetic, and `round` turns the
+ * result for the queried signal back into Hz.
+ */
+
+/// Whole Hz in 32 bits, the default. Every element truncates its output.
+struct Hz32 {
+    using type = uint32_t;
+
+    static constexpr type from(uint32_t hz) { return hz; }
+    static constexpr uint32_t round(type f) { return f; }
+    static constexpr type div(type f, uint32_t d) { return f / d; }
+
+    /// f * mul / div with a 64-bit intermediate.
+    static constexpr type scale(type f, uint64_t mul, uint64_t div) { return type(f * mul / div); }
+};
+
+/// Q32.32 fixed-point Hz in 64 bits. Fractional PLL and divider outputs keep
+/// 32 fraction bits down the chain and are rounded to the nearest Hz only at
+/// the queried signal. Needs no 128-bit arithmetic, but each element costs a
+/// few 64-bit divisions.
+struct Q32_32 {
+    using type = uint64_t;
+
+    static constexpr type from(uint32_t hz) { return uint64_t(hz) << 32; }
+    static constexpr uint32_t round(type f) { return uint32_t((f + (uint64_t(1) << 31)) >> 32); }
+    static constexpr type div(type f, uint32_t d) { return f / d; }
+
+    /// f * mul / div, rounded down. Factors beyond 32 bits lose their
+    /// lowest bits.
+    static constexpr type scale(type f, uint64_t mul, uint64_t div) {
+        while ((mul | div) >> 32) {
+            mul >>= 1;
+            div >>= 1;
+        }
+        if (!div) return 0;
+        // f * mul = hi * 2^32 + lo, divided in two 64-bit steps
+        uint64_t hi = (f >> 32) * mul, lo = (f & 0xFFFFFFFF) * mul;
+        uint64_t t = (hi % div) << 32;
+        return ((hi / div) << 32) + t / div + lo / div + (t % div + lo % div) / div;
+    }
+};
 
 // ---------------------------------------------------------------------------
 // Standard frequency functions
 // ---------------------------------------------------------------------------
 
+/// Input selection: no input (generators).
+template<typename Id>
+Id no_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx);
+
+/// Input selection: the first input (dividers, PLLs, pass-throughs).
+template<typename Id>
+Id first_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx);
+
+/// Input selection of a gate: the input while the enable bit is set.
+template<typename Id>
+Id gate_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx);
+
+/// Input selection of an inverted gate: the input while the enable bit is clear.
+template<typename Id>
+Id gate_inv_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx);
+
+/// Input selection of a multiplexer: the input chosen by the register field.
+template<typename Id>
+Id mux_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx);
+
 /// Gate: output = input if enable bit is set, else 0.
-inline uint32_t gate_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+template<typename Id>
+uint32_t gate_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
 /// Inverted gate: output = input if enable bit is clear, else 0.
-inline uint32_t gate_inv_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+template<typename Id>
+uint32_t gate_inv_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
-/// Unconditional pass-through (gate without control bit).
-inline uint32_t passthrough_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+/// Unconditional pass-through (gate without control bit), also used for
+/// multiplexers, whose input selection does all the work.
+template<typename Id>
+uint32_t passthrough_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
 /// Generator with fixed frequency.
-inline uint32_t gen_fixed_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+template<typename Id>
+uint32_t gen_fixed_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
 /// Generator with external (runtime) frequency.
-inline uint32_t gen_external_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+template<typename Id>
+uint32_t gen_external_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
 /// Divider with table lookup.
-inline uint32_t table_div_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+template<typename Id>
+uint32_t table_div_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
 /// Divider with linear formula: divisor = raw + offset.
-inline uint32_t linear_div_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+template<typename Id>
+uint32_t linear_div_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
 /// Fixed divider: always divides by a constant.
-inline uint32_t fixed_div_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+template<typename Id>
+uint32_t fixed_div_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
-/// Multiplexer: selects one input based on register field.
-inline uint32_t mux_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+/// Fractional divider: divisor = INT + FRAC / 2^frac_bits, or base + N / D.
+template<typename Id>
+uint32_t frac_div_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
 
 /// PLL: output = input * (N + frac) / post_div.
-inline uint32_t pll_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree);
+template<typename Id>
+uint32_t pll_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx);
+
+// Sources, dividers and PLLs also have an overload taking the typed
+// descriptor. It is constexpr and templated on the context, so that the
+// compile-time specialized and constant-evaluated queries can call it
+// directly with a DirectContext, and on the precision policy `P`.
+
+template<typename P = Hz32, typename Ctx>
+constexpr typename P::type gen_fixed_freq(GenFixedDesc const& g, typename P::type in_freq, Ctx const& ctx);
+
+template<typename P = Hz32, typename Ctx>
+constexpr typename P::type gen_external_freq(GenExternalDesc const& g, typename P::type in_freq, Ctx const& ctx);
+
+template<typename P = Hz32, typename Ctx>
+constexpr typename P::type table_div_freq(TableDivDesc const& d, typename P::type in_freq, Ctx const& ctx);
+
+template<typename P = Hz32, typename Ctx>
+constexpr typename P::type linear_div_freq(LinearDivDesc const& d, typename P::type in_freq, Ctx const& ctx);
+
+template<typename P = Hz32, typename Ctx>
+constexpr typename P::type fixed_div_freq(FixedDivDesc const& d, typename P::type in_freq, Ctx const& ctx);
+
+template<typename P = Hz32, typename Ctx>
+constexpr typename P::type frac_div_freq(FracDivDesc const& d, typename P::type in_freq, Ctx const& ctx);
+
+template<typename P = Hz32, typename Ctx>
+constexpr typename P::type pll_freq(PllDesc const& p, typename P::type in_freq, Ctx const& ctx);
 
 // ---------------------------------------------------------------------------
 // ClockTreeBase — the generic clock tree interpreter
@@ -204,27 +526,202 @@ inline uint32_t pll_freq(void const* desc, uint8_t const* inputs, ClockTreeBase
  * constexpr data tables. ClockTree<Clocks> then inherits from this and
  * exposes the public API.
  */
-class ClockTreeBase {
+template<typename Id> class ClockTreeBase {
 public:
-    /// Get frequency of given signal in Hz. Returns 0 for disabled/unknown signals.
-    uint32_t getFrequency(uint8_t sig_id) const {
+    /// Discard all cached frequencies. Call after writing any register that
+    /// affects the clock tree. Without a cache attached this is a no-op apart
+    /// from bumping the epoch counter.
+    void invalidate() {
+        if (++epoch == 0) {
+            // Epoch counter wrapped: stale entries could match again, so
+            // clear them explicitly and restart at 1.
+            if (cache_epoch)
+                for (uint16_t i = 0; i < signal_count; ++i)
+                    cache_epoch[i] = 0;
+            epoch = 1;
+        }
+    }
+
+protected:
+    /// Frequencies already known within one query, in the representation of
+    /// a precision policy: freqs[i] is valid when bit i of the `valid` bitset
+    /// is set.
+    template<typename T> struct MemoOf {
+        T*        freqs;
+        uint32_t* valid;
+    };
+    using Memo = MemoOf<uint32_t>;
+
+    /** Get frequency of given signal in the representation of the precision
+     * policy P. Returns 0 for disabled/unknown signals.
+     *
+     * The evaluation is iterative: it follows the selected inputs from the
+     * signal towards its source, recording the signals passed in a path
+     * array of MaxDepth entries, then applies their frequency functions in
+     * reverse order. Both steps switch on the element kind and call the
+     * standard functions directly, without going through the type table.
+     * The walk stops early at a signal whose frequency is already known from
+     * `memo` or, with `Cached`, the cache, and every frequency computed on
+     * the way back is stored in both. The cache holds whole Hz, so only Hz32
+     * queries use it. MaxDepth is the generated `max_depth`, the longest
+     * chain of elements in the tree, so the stack use is fixed and there is
+     * no recursion.
+     */
+    template<size_t MaxDepth, typename P = Hz32, bool Cached = std::is_same_v<P, Hz32>>
+    typename P::type getFrequency(Id sig_id, EvalContext<Id> const& ctx,
+                                  MemoOf<typename P::type> const* memo = nullptr) const {
         if (sig_id == 0 || sig_id >= signal_count) [[unlikely]]
             return 0;
+        Id path[MaxDepth];
+        size_t depth = 0;
+        typename P::type f = 0;
+        for (Id id = sig_id; id != 0; ) {
+            if (lookup<Cached>(id, memo, f))
+                break;
+            auto& s = signals[id];
+            if (s.type == 0)
+                break;
+            if (depth == MaxDepth) [[unlikely]]
+                return 0;
+            path[depth++] = id;
+            id = inputOf(s, ctx);
+        }
+        while (depth) {
+            Id id = path[--depth];
+            f = apply<P>(signals[id], f, ctx);
+            store<Cached>(id, f, memo);
+        }
+        return f;
+    }
+
+    /// Input currently selected by the element driving signal `s`, 0 if none.
+    Id inputOf(Signal<Id> const& s, EvalContext<Id> const& ctx) const {
+        void const* desc = descriptor(s);
+        Id const* in = &input_pool[s.input_offset];
+        switch (types[s.type].kind) {
+        case Kind::Gate:        return gate_input(desc, in, ctx);
+        case Kind::GateInv:     return gate_inv_input(desc, in, ctx);
+        case Kind::Mux:         return mux_input(desc, in, ctx);
+        case Kind::GenFixed:
+        case Kind::GenExternal: return 0;
+        default:                return in[0];
+        }
+    }
+
+    /// Output frequency of the element driving signal `s` for the frequency
+    /// `f` of its selected input. Gates and muxes act through the input
+    /// selection alone, so they pass `f` on.
+    template<typename P>
+    typename P::type apply(Signal<Id> const& s, typename P::type f, EvalContext<Id> const& ctx) const {
+        void const* desc = descriptor(s);
+        switch (types[s.type].kind) {
+        case Kind::GenFixed:    return gen_fixed_freq<P>(*static_cast<GenFixedDesc const*>(desc), f, ctx);
+        case Kind::GenExternal: return gen_external_freq<P>(*static_cast<GenExternalDesc const*>(desc), f, ctx);
+        case Kind::TableDiv:    return table_div_freq<P>(*static_cast<TableDivDesc const*>(desc), f, ctx);
+        case Kind::LinearDiv:   return linear_div_freq<P>(*static_cast<LinearDivDesc const*>(desc), f, ctx);
+        case Kind::FixedDiv:    return fixed_div_freq<P>(*static_cast<FixedDivDesc const*>(desc), f, ctx);
+        case Kind::FracDiv:     return frac_div_freq<P>(*static_cast<FracDivDesc const*>(desc), f, ctx);
+        case Kind::Pll:         return pll_freq<P>(*static_cast<PllDesc const*>(desc), f, ctx);
+        default:                return f;
+        }
+    }
+
+    /// Evaluate every signal in a single forward sweep over the generated
+    /// topological order, using the frequencies already stored in `out`,
+    /// which must have room for all signals.
+    void evaluateAll(uint32_t* out, EvalContext<Id> const& ctx) const {
+        sweep(out, ctx);
+        if (cache_freq) {
+            uint16_t ep = epoch;
+            for (uint16_t i = 0; i < signal_count; ++i) {
+                cache_freq[i] = out[i];
+                cache_epoch[i] = ep;
+            }
+        }
+    }
+
+    /// The forward sweep of evaluateAll(), without the cache: out[] must
+    /// have room for all signals. Signals in the `stopped` bitset, if given,
+    /// evaluate to 0.
+    void sweep(uint32_t* out, EvalContext<Id> const& ctx, uint32_t const* stopped = nullptr) const {
+        for (uint16_t i = 0; i < signal_count; ++i) {
+            Id id = order[i];
+            auto& s = signals[id];
+            if (s.type == 0 || (stopped && (stopped[id >> 5] & (1u << (id & 31))))) {
+                out[id] = 0;
+                continue;
+            }
+            auto& t = types[s.type];
+            auto desc = descriptor(s);
+            out[id] = t.freq(desc, out[t.input(desc, &input_pool[s.input_offset], ctx)], ctx);
+        }
+    }
+
+    /// Input currently selected by the element driving a signal, 0 if none.
+    Id selectedInput(Id sig_id, EvalContext<Id> const& ctx) const {
         auto& s = signals[sig_id];
-        if (s.type == 0) [[unlikely]]
+        if (s.type == 0)
             return 0;
+        return types[s.type].input(descriptor(s), &input_pool[s.input_offset], ctx);
+    }
+
+    /// Drop the cached frequency of one signal.
+    void discard(Id sig_id) {
+        if (cache_epoch)
+            cache_epoch[sig_id] = 0;
+    }
+
+    /// Look up the frequency of a signal in the memo and, with `Cached`, the cache.
+    template<bool Cached, typename T>
+    bool lookup(Id sig_id, MemoOf<T> const* memo, T& f) const {
+        if (memo && (memo->valid[sig_id >> 5] & (1u << (sig_id & 31)))) {
+            f = memo->freqs[sig_id];
+            return true;
+        }
+        if constexpr (Cached) {
+            if (cache_freq && cache_epoch[sig_id] == epoch) {
+                f = cache_freq[sig_id];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Record the frequency of a signal in the memo and, with `Cached`, the cache.
+    template<bool Cached, typename T>
+    void store(Id sig_id, T f, MemoOf<T> const* memo) const {
+        if (memo) {
+            memo->freqs[sig_id] = f;
+            memo->valid[sig_id >> 5] |= 1u << (sig_id & 31);
+        }
+        if constexpr (Cached) {
+            if (cache_freq) {
+                cache_freq[sig_id] = f;
+                cache_epoch[sig_id] = epoch;
+            }
+        }
+    }
+
+    /// Descriptor of the element driving a signal.
+    void const* descriptor(Signal<Id> const& s) const {
         auto& t = types[s.type];
-        auto desc = static_cast<uint8_t const*>(t.descriptors) + s.desc_index * t.desc_size;
-        return t.freq(desc, &input_pool[s.input_offset], *this);
+        return static_cast<uint8_t const*>(t.descriptors) + s.desc_index * t.desc_size;
     }
 
-protected:
     // These are set by the generated per-chip Clocks struct's constructor
     // or initialized via aggregate initialization.
-    Signal const*    signals;
-    uint16_t         signal_count;
-    BlockType const* types;
-    uint8_t const*   input_pool;
+    Signal<Id> const*    signals;
+    uint16_t             signal_count;
+    BlockType<Id> const* types;
+    Id const*            input_pool;
+    Id const*            order;     ///< All signal IDs, inputs before outputs
+
+    // Optional frequency cache, attached by CachedClockTree. An entry is
+    // valid when its epoch tag equals the current epoch; epoch 0 is never
+    // current, so zero-initialized tags start out invalid.
+    uint32_t*        cache_freq = nullptr;
+    uint16_t*        cache_epoch = nullptr;
+    uint16_t         epoch = 1;
 
 public:
     // Accessible by frequency functions for table lookups and mutable state
@@ -232,111 +729,1850 @@ public:
     uint32_t*        state;
 };
 
+// ---------------------------------------------------------------------------
+// Frequency-change subscriptions
+// ---------------------------------------------------------------------------
+
+/** Subscription to the frequency of one signal.
+ *
+ * Owned by the subscriber, typically a driver, and linked into the tree by
+ * ClockTree::subscribe(). The callback runs from ClockTree::update() when
+ * the frequency of the signal has changed; `frequency` then already holds
+ * the new value.
+ */
+template<typename S> struct Subscription {
+    using Callback = void(*)(Subscription& sub, uint32_t old_freq);
+
+    S             signal;               ///< Signal to watch
+    Callback      callback;             ///< Called after the frequency changed
+    void*         context = nullptr;    ///< For use by the callback
+    uint32_t      frequency = 0;        ///< Last known frequency, maintained by the tree
+    Subscription* next = nullptr;       ///< Next subscription of the same tree
+};
+
+// ---------------------------------------------------------------------------
+// Frequency limits
+// ---------------------------------------------------------------------------
+
+/// Datasheet frequency range of a signal, with its nominal frequency (0 if
+/// the model gives none). Without `min`/`max` the range is unbounded.
+struct Limits : Range {
+    uint32_t nominal;
+};
+static_assert(sizeof(void*) != 4 || sizeof(Limits) == 12);
+
+/// A signal outside its limits, as reported by ClockTree::audit().
+template<typename S> struct Violation {
+    S        signal;
+    uint32_t frequency;
+};
+
+// ---------------------------------------------------------------------------
+// Configuration planning
+// ---------------------------------------------------------------------------
+
+/// Frequency requirement for ClockTree::plan(): min <= frequency <= max.
+template<typename S> struct Requirement {
+    S        signal;
+    uint32_t min;
+    uint32_t max = 0xFFFFFFFF;
+};
+
+/// Values of some bits of a clock register.
+struct RegisterSetting {
+    uintptr_t addr;             ///< Register address
+    uint32_t  mask;             ///< Bits set by the plan
+    uint32_t  value;            ///< Their values, 0 outside mask
+};
+
+/// One step of a reconfiguration sequence from ClockTree::sequence().
+template<typename S> struct Step {
+    enum class Action : uint8_t {
+        Write,                  ///< Write `setting`: reg = (reg & ~mask) | value
+        StopPll,                ///< Stop PLL `signal` before its input or factors change
+        StartPll,               ///< Start PLL `signal` and wait for lock
+        Raise,                  ///< `signal` is about to rise to `frequency`
+        Lower,                  ///< `signal` has dropped to `frequency`
+    };
+
+    Action          action;
+    S               signal;     ///< Written element, PLL or watched signal
+    uint32_t        frequency;  ///< Frequency of `signal` after the step
+    RegisterSetting setting;    ///< Bits of a Write step
+};
+
 // ---------------------------------------------------------------------------
 // ClockTree — the public-facing template
 // ---------------------------------------------------------------------------
 
-/** ClockTree class template, parameterized with the generated Clocks struct. */
-template<typename Clocks> class ClockTree : public Clocks {
+/** ClockTree class template, parameterized with the generated Clocks struct,
+ * the register access backend and the precision policy.
+ *
+ * Each query reads every register word it needs exactly once, into a
+ * Snapshot on the stack. The generated Clocks struct provides the address
+ * of word offset 0 as `register_base`, and the sizes: `snapshot_words` is
+ * the largest number of distinct words on the path of any single signal,
+ * `register_words` the number of words in the whole tree.
+ *
+ * A backend with state, such as RegisterImage, is passed as the first
+ * constructor argument, ahead of the Clocks arguments.
+ *
+ * With the Q32_32 precision policy, getFrequency(), getFrequencies() and
+ * evaluateWith() carry the frequencies through the chain in fixed point and
+ * round only the result, so fractional PLL outputs, e.g. of audio PLLs,
+ * don't lose accuracy at every divider behind them. These queries then
+ * bypass the cache. The whole-tree sweeps, the planner and the sequencer
+ * always work in whole Hz.
+ */
+template<typename Clocks, typename Backend = MmioBackend, typename Precision = Hz32>
+class ClockTree : public Clocks {
 public:
     using S = typename Clocks::S;
+    using Id = typename Clocks::Id;
+
+    template<typename... Args> requires std::is_constructible_v<Clocks, Args...>
+    constexpr ClockTree(Args&&... args) : Clocks(std::forward<Args>(args)...) {}
 
     template<typename... Args>
-    ClockTree(Args&&... args) : Clocks(std::forward<Args>(args)...) {}
+    constexpr ClockTree(Backend backend, Args&&... args) : Clocks(std::forward<Args>(args)...), backend_(backend) {}
+
+    /// Number of signals in the tree, including the empty signal 0.
+    static constexpr size_t num_signals = sizeof(Clocks::signal_table) / sizeof(Clocks::signal_table[0]);
+
+    /// Get frequency of given signal in Hz. Returns 0 for disabled/unknown signals.
+    /// Also usable in constant expressions, with a constexpr backend such
+    /// as a RegisterImage of constexpr arrays.
+    constexpr uint32_t getFrequency(S s) const {
+        return Precision::round(getExactFrequency(s));
+    }
+
+    /// Get the frequency of a signal in the representation of the precision
+    /// policy, e.g. Q32.32 Hz, before rounding.
+    constexpr typename Precision::type getExactFrequency(S s) const {
+        if (std::is_constant_evaluated()) {
+            DirectContext<Id, Clocks::register_base, Backend> ctx{*this, backend_};
+            return frequencyOf<Precision>(static_cast<Id>(s), ctx);
+        }
+        SnapshotBuffer<Clocks::snapshot_words> regs{Clocks::register_base, load, &backend_};
+        EvalContext<Id> ctx{*this, regs};
+        return Clocks::template getFrequency<Clocks::max_depth, Precision>(static_cast<Id>(s), ctx);
+    }
+
+    /** Get frequency of a signal known at compile time.
+     *
+     * The path from the signal to its sources is unrolled at compile time
+     * from the constexpr tables, so the query compiles to the register
+     * reads and arithmetic of the elements on that path, with a branch for
+     * each multiplexer input, and without indirect calls. Only the
+     * frequency functions of the element kinds on the path are
+     * instantiated. Registers are read directly, one load per field, and
+     * the cache is not used.
+     */
+    template<S s> constexpr uint32_t getFrequency() const {
+        DirectContext<Id, Clocks::register_base, Backend> ctx{*this, backend_};
+        return Precision::round(frequencyOf<static_cast<Id>(s), Precision>(ctx));
+    }
+
+    /** Find the PLL settings that bring signal `s` closest to `target` Hz.
+     *
+     * `s` must be the output of one of the generated `pll_paths`, i.e. a
+     * PLL output or the output of a divider directly behind a PLL. The input
+     * frequency is that of the path's input signal as currently configured.
+     * The settings are not applied. Returns frequency 0 when `s` has no path
+     * or no setting meets the limits of the path.
+     */
+    constexpr PllSettings solvePll(S s, uint32_t target) const
+        requires requires { Clocks::pll_paths; } {
+        if (auto const* p = pllPath(s))
+            return solve_pll(*p, getFrequency(static_cast<S>(p->input)), target);
+        return {};
+    }
+
+    /// As above, for a given input frequency, e.g. for a fixed configuration
+    /// computed at compile time.
+    static constexpr PllSettings solvePll(S s, uint32_t in_freq, uint32_t target)
+        requires requires { Clocks::pll_paths; } {
+        if (auto const* p = pllPath(s))
+            return solve_pll(*p, in_freq, target);
+        return {};
+    }
+
+    /// Register settings produced by plan(), in ascending address order.
+    struct Plan {
+        RegisterSetting settings[Clocks::register_words];
+        uint16_t        count = 0;
+
+        RegisterSetting const* begin() const { return settings; }
+        RegisterSetting const* end() const { return settings + count; }
+    };
+
+    /** Find register settings that meet all requirements at once.
+     *
+     * The planner searches the mux selections, divider factors, PLL factors
+     * and gate enables on the paths of the required signals, starting from
+     * the current register contents, and returns the bits it decided on.
+     * Every signal on a chosen path also stays within its generated
+     * `limits`. Returns false if no assignment was found within `max_steps`
+     * search steps; `out` is then left unchanged. The settings are not
+     * applied.
+     *
+     * Intended for the host, e.g. with a RegisterImage backend, to derive
+     * the clock configuration of a product; a search takes milliseconds
+     * there. The search state lives on the stack and grows with the
+     * register count, about 12 bytes per register bit.
+     */
+    bool plan(std::span<Requirement<S> const> reqs, Plan& out, uint32_t max_steps = 1'000'000) const
+        requires requires { Clocks::limits; } {
+        Planner planner{*this, max_steps};
+        if (!planner.solve(reqs))
+            return false;
+        planner.result(out);
+        return true;
+    }
+
+    /// Steps produced by sequence(), to be carried out in order.
+    struct Sequence {
+        Step<S>  steps[8 * Clocks::register_words];
+        uint16_t count = 0;
+
+        Step<S> const* begin() const { return steps; }
+        Step<S> const* end() const { return steps + count; }
+    };
+
+    /** Find a safe order of register writes from the current configuration
+     * to `target`, such as a Plan.
+     *
+     * Only the fields that differ are written, and fields of the same
+     * register are combined where that is safe. No write takes a signal
+     * outside its generated `limits` unless it was outside at the start, or
+     * stops a clock that runs both before and in the target. No write
+     * changes a PLL, or a divider right behind one, while it feeds a running
+     * leaf clock. Where the target needs that, the consumers are first moved
+     * away: a mux is switched to another running input, or as a last resort
+     * a gate is closed or a mux switched to a stopped input, and restored
+     * once the PLL is done. A PLL is stopped before its first write, outputs
+     * nothing until it is started after its last one, and is only started if
+     * the target uses it. For each signal in `watch`, a Raise step comes
+     * before every step that raises its frequency and a Lower step after
+     * every step that lowers it, e.g. to adjust the flash wait states for
+     * the bus clock.
+     *
+     * Returns false if no safe order was found or `out` is too small. The
+     * steps are computed, not carried out; on the host, with a RegisterImage
+     * backend, they make a dry run.
+     *
+     * The sequencer state lives on the stack: a copy of the clock registers,
+     * the frequency of every signal and a pending change per field use and
+     * signal, about 20 bytes per signal and field use. That is some 7 KB for
+     * the STM32H7 on a 32-bit core, so this is not for small stacks, such as
+     * those of interrupt handlers or most RTOS tasks.
+     */
+    bool sequence(std::span<RegisterSetting const> target, std::span<S const> watch, Sequence& out) const
+        requires requires { Clocks::limits; } {
+        Sequencer sequencer{*this, watch, out};
+        return sequencer.run(target);
+    }
+
+    /// Register a subscription and record the current frequency of its signal.
+    void subscribe(Subscription<S>& sub) {
+        sub.frequency = getFrequency(sub.signal);
+        sub.next = subs_;
+        subs_ = &sub;
+    }
+
+    /// Remove a subscription. Safe to call from its own callback.
+    void unsubscribe(Subscription<S>& sub) {
+        for (auto** p = &subs_; *p; p = &(*p)->next) {
+            if (*p == &sub) {
+                *p = sub.next;
+                return;
+            }
+        }
+    }
+
+    /** Report a write to the clock register at `addr`, and notify the
+     * subscribers whose clock changed as a result.
+     *
+     * The generated field_uses table gives the signals whose elements read
+     * the written bits (`mask`), and one pass over the topological order
+     * through the fanout table extends that to everything downstream. Only
+     * those signals are dropped from the cache and only subscriptions to
+     * them are re-evaluated, so a divider change re-evaluates just the
+     * affected subtree.
+     */
+    void update(uintptr_t addr, uint32_t mask = 0xFFFFFFFF) {
+        uint32_t affected[words] = {};
+        uintptr_t word = (addr - Clocks::register_base) >> 2;
+        bool any = false;
+        for (auto& u : Clocks::field_uses) {
+            if (u.word_offset == word && (u.mask & mask)) {
+                mark(affected, u.signal);
+                any = true;
+            }
+        }
+        if (!any)
+            return;
+        for (size_t i = 0; i < num_signals; ++i) {
+            Id id = Clocks::topo_order[i];
+            if (isMarked(affected, id))
+                for (uint16_t k = Clocks::fanout_offsets[id]; k < Clocks::fanout_offsets[id + 1]; ++k)
+                    mark(affected, Clocks::fanout_pool[k]);
+        }
+        notify(affected);
+    }
 
-    uint32_t getFrequency(S s) const {
-        return ClockTreeBase::getFrequency(static_cast<uint8_t>(s));
+    /// Notify the subscribers after an arbitrary change of the clock tree,
+    /// e.g. of an external oscillator frequency in the state slots.
+    void update() {
+        uint32_t affected[words];
+        for (auto& w : affected)
+            w = 0xFFFFFFFF;
+        notify(affected);
+    }
+
+    /// Evaluate every signal in a single forward sweep over the generated
+    /// topological order, so each element is computed exactly once from its
+    /// already-evaluated inputs. out[i] receives the frequency of signal i.
+    /// With a cache attached, the cache is refreshed as well.
+    void evaluateAll(std::span<uint32_t, num_signals> out) const {
+        SnapshotBuffer<Clocks::register_words> regs{Clocks::register_base, load, &backend_};
+        EvalContext<Id> ctx{*this, regs};
+        Clocks::evaluateAll(out.data(), ctx);
+    }
+
+    /// Get the frequencies of several signals in one query. The elements on
+    /// the paths of the requested signals are evaluated once each, so shared
+    /// prefixes (PLLs, system and bus clocks) are not walked again for every
+    /// signal. out[i] receives the frequency of sigs[i]; if the spans differ
+    /// in length, the excess entries are ignored.
+    void getFrequencies(std::span<S const> sigs, std::span<uint32_t> out) const {
+        SnapshotBuffer<Clocks::register_words> regs{Clocks::register_base, load, &backend_};
+        EvalContext<Id> ctx{*this, regs};
+        frequenciesOf<true>(sigs, out, ctx);
+    }
+
+    /** Check every signal against its datasheet limits.
+     *
+     * The tree is evaluated in a single forward sweep as in evaluateAll(),
+     * and each signal is then compared with its entry in the generated
+     * `limits` table. Stopped signals (frequency 0) are not reported. The
+     * first violations, in signal order, are stored in `out`; the return
+     * value is the total number, which may exceed out.size(). `audit({})`
+     * only counts them.
+     */
+    size_t audit(std::span<Violation<S>> out) const requires requires { Clocks::limits; } {
+        uint32_t freqs[num_signals];
+        evaluateAll(freqs);
+        size_t n = 0;
+        for (size_t i = 0; i < num_signals; ++i) {
+            uint32_t f = freqs[i];
+            if (f == 0 || (f >= Clocks::limits[i].min && f <= Clocks::limits[i].max))
+                continue;
+            if (n < out.size())
+                out[n] = {static_cast<S>(i), f};
+            ++n;
+        }
+        return n;
+    }
+
+    /// Set of signals, one bit per signal ID.
+    struct SignalSet {
+        uint32_t bits[(num_signals + 31) / 32] = {};
+
+        bool contains(S s) const { return isMarked(bits, static_cast<Id>(s)); }
+    };
+
+    /** Get the signals contributing to a running leaf clock.
+     *
+     * A leaf is a signal that feeds no element, such as a peripheral or
+     * core clock. After one forward sweep as in evaluateAll(), a backward
+     * sweep over the topological order starts at every leaf with a non-zero
+     * frequency and marks the input each element currently selects. The
+     * result holds every signal on those paths, including the outputs of
+     * the oscillators, PLLs and gates that must keep running; the others
+     * can be stopped without affecting any running leaf.
+     */
+    SignalSet activeClocks() const {
+        uint32_t freqs[num_signals];
+        SnapshotBuffer<Clocks::register_words> regs{Clocks::register_base, load, &backend_};
+        EvalContext<Id> ctx{*this, regs};
+        Clocks::evaluateAll(freqs, ctx);
+        SignalSet active;
+        markActive(freqs, active.bits, ctx);
+        return active;
+    }
+
+    /** Get the frequency a signal would have with some register bits changed.
+     *
+     * `overlay` lists pending writes, such as a Plan, which are applied on
+     * top of the register contents as each word is loaded into the query's
+     * snapshot, so the lookup runs once per word and not per field. The
+     * registers are not written; later entries for the same bits take
+     * precedence. The cache is neither used nor updated.
+     */
+    uint32_t evaluateWith(std::span<RegisterSetting const> overlay, S s) const {
+        Overlay ov{overlay, &backend_};
+        SnapshotBuffer<Clocks::snapshot_words> regs{Clocks::register_base, loadOverlay, &ov};
+        EvalContext<Id> ctx{*this, regs};
+        return Precision::round(
+            Clocks::template getFrequency<Clocks::max_depth, Precision, false>(static_cast<Id>(s), ctx));
+    }
+
+    uint32_t evaluateWith(std::initializer_list<RegisterSetting> overlay, S s) const {
+        return evaluateWith(std::span<RegisterSetting const>{overlay.begin(), overlay.size()}, s);
+    }
+
+    /// Get the frequencies several signals would have with the register bits
+    /// in `overlay` changed, from a single snapshot. Shared prefixes are
+    /// evaluated once, as in getFrequencies(). out[i] receives the frequency
+    /// of sigs[i]; if the spans differ in length, the excess entries are
+    /// ignored.
+    void evaluateWith(std::span<RegisterSetting const> overlay, std::span<S const> sigs,
+                      std::span<uint32_t> out) const {
+        Overlay ov{overlay, &backend_};
+        SnapshotBuffer<Clocks::register_words> regs{Clocks::register_base, loadOverlay, &ov};
+        EvalContext<Id> ctx{*this, regs};
+        frequenciesOf<false>(sigs, out, ctx);
+    }
+
+private:
+    /// Frequencies of several signals with one memo, in whole Hz. With
+    /// Hz32 and `Cached`, the cache is used as well.
+    template<bool Cached>
+    void frequenciesOf(std::span<S const> sigs, std::span<uint32_t> out, EvalContext<Id> const& ctx) const {
+        using T = typename Precision::type;
+        T freqs[num_signals];
+        uint32_t valid[words] = {};
+        typename Clocks::template MemoOf<T> memo{freqs, valid};
+        size_t n = sigs.size() < out.size() ? sigs.size() : out.size();
+        for (size_t i = 0; i < n; ++i)
+            out[i] = Precision::round(Clocks::template getFrequency<Clocks::max_depth, Precision,
+                                                                   Cached && std::is_same_v<Precision, Hz32>>(
+                static_cast<Id>(sigs[i]), ctx, &memo));
+    }
+
+    /// Frequency of signal `id`, unrolled at compile time.
+    template<Id id, typename P = Hz32, typename Ctx> constexpr typename P::type frequencyOf(Ctx const& ctx) const {
+        constexpr auto sig = Clocks::signal_table[id];
+        if constexpr (id == 0 || id >= num_signals || sig.type == 0) {
+            return 0;
+        } else {
+            constexpr Kind kind = Clocks::type_table[sig.type].kind;
+            constexpr Id in0 = Clocks::input_pool_data[sig.input_offset];
+            if constexpr (kind == Kind::Gate) {
+                constexpr auto& d = Clocks::gate_descs[sig.desc_index];
+                return ctx.bit(d.addr) ? frequencyOf<in0, P>(ctx) : 0;
+            } else if constexpr (kind == Kind::GateInv) {
+                constexpr auto& d = Clocks::gate_inv_descs[sig.desc_index];
+                return ctx.bit(d.addr) ? 0 : frequencyOf<in0, P>(ctx);
+            } else if constexpr (kind == Kind::Passthrough) {
+                return frequencyOf<in0, P>(ctx);
+            } else if constexpr (kind == Kind::GenFixed) {
+                return gen_fixed_freq<P>(Clocks::gen_fixed_descs[sig.desc_index], 0, ctx);
+            } else if constexpr (kind == Kind::GenExternal) {
+                return gen_external_freq<P>(Clocks::gen_external_descs[sig.desc_index], 0, ctx);
+            } else if constexpr (kind == Kind::TableDiv) {
+                return table_div_freq<P>(Clocks::table_div_descs[sig.desc_index], frequencyOf<in0, P>(ctx), ctx);
+            } else if constexpr (kind == Kind::LinearDiv) {
+                return linear_div_freq<P>(Clocks::linear_div_descs[sig.desc_index], frequencyOf<in0, P>(ctx), ctx);
+            } else if constexpr (kind == Kind::FixedDiv) {
+                return fixed_div_freq<P>(Clocks::fixed_div_descs[sig.desc_index], frequencyOf<in0, P>(ctx), ctx);
+            } else if constexpr (kind == Kind::FracDiv) {
+                return frac_div_freq<P>(Clocks::frac_div_descs[sig.desc_index], frequencyOf<in0, P>(ctx), ctx);
+            } else if constexpr (kind == Kind::Mux) {
+                constexpr auto& d = Clocks::mux_descs[sig.desc_index];
+                return selectInput<sig.input_offset, 0, d.input_count, P>(ctx.field(d.field), ctx);
+            } else {
+                static_assert(kind == Kind::Pll);
+                return pll_freq<P>(Clocks::pll_descs[sig.desc_index], frequencyOf<in0, P>(ctx), ctx);
+            }
+        }
+    }
+
+    /// Frequency of multiplexer input `sel`, one branch per input.
+    template<uint16_t offset, size_t k, size_t n, typename P, typename Ctx>
+    constexpr typename P::type selectInput(uint32_t sel, Ctx const& ctx) const {
+        if constexpr (k == n)
+            return 0;
+        else
+            return sel == k ? frequencyOf<Clocks::input_pool_data[offset + k], P>(ctx)
+                            : selectInput<offset, k + 1, n, P>(sel, ctx);
     }
+
+    /// Frequency of signal `id` for constant evaluation. Works like the
+    /// interpreter, but reaches the descriptors through their typed arrays,
+    /// since a void pointer can't be cast back in a constant expression.
+    template<typename P = Hz32, typename Ctx> constexpr typename P::type frequencyOf(Id id, Ctx const& ctx) const {
+        if (id == 0 || id >= num_signals)
+            return 0;
+        auto sig = Clocks::signal_table[id];
+        if (sig.type == 0)
+            return 0;
+        Id const* in = &Clocks::input_pool_data[sig.input_offset];
+        switch (Clocks::type_table[sig.type].kind) {
+        case Kind::Gate:
+            if constexpr (requires { Clocks::gate_descs; })
+                return ctx.bit(Clocks::gate_descs[sig.desc_index].addr) ? frequencyOf<P>(in[0], ctx) : 0;
+            break;
+        case Kind::GateInv:
+            if constexpr (requires { Clocks::gate_inv_descs; })
+                return ctx.bit(Clocks::gate_inv_descs[sig.desc_index].addr) ? 0 : frequencyOf<P>(in[0], ctx);
+            break;
+        case Kind::Passthrough:
+            return frequencyOf<P>(in[0], ctx);
+        case Kind::GenFixed:
+            if constexpr (requires { Clocks::gen_fixed_descs; })
+                return gen_fixed_freq<P>(Clocks::gen_fixed_descs[sig.desc_index], 0, ctx);
+            break;
+        case Kind::GenExternal:
+            if constexpr (requires { Clocks::gen_external_descs; })
+                return gen_external_freq<P>(Clocks::gen_external_descs[sig.desc_index], 0, ctx);
+            break;
+        case Kind::TableDiv:
+            if constexpr (requires { Clocks::table_div_descs; })
+                return table_div_freq<P>(Clocks::table_div_descs[sig.desc_index], frequencyOf<P>(in[0], ctx), ctx);
+            break;
+        case Kind::LinearDiv:
+            if constexpr (requires { Clocks::linear_div_descs; })
+                return linear_div_freq<P>(Clocks::linear_div_descs[sig.desc_index], frequencyOf<P>(in[0], ctx), ctx);
+            break;
+        case Kind::FixedDiv:
+            if constexpr (requires { Clocks::fixed_div_descs; })
+                return fixed_div_freq<P>(Clocks::fixed_div_descs[sig.desc_index], frequencyOf<P>(in[0], ctx), ctx);
+            break;
+        case Kind::FracDiv:
+            if constexpr (requires { Clocks::frac_div_descs; })
+                return frac_div_freq<P>(Clocks::frac_div_descs[sig.desc_index], frequencyOf<P>(in[0], ctx), ctx);
+            break;
+        case Kind::Mux:
+            if constexpr (requires { Clocks::mux_descs; }) {
+                auto& d = Clocks::mux_descs[sig.desc_index];
+                uint32_t sel = ctx.field(d.field);
+                return sel < d.input_count ? frequencyOf<P>(in[sel], ctx) : 0;
+            }
+            break;
+        case Kind::Pll:
+            if constexpr (requires { Clocks::pll_descs; })
+                return pll_freq<P>(Clocks::pll_descs[sig.desc_index], frequencyOf<P>(in[0], ctx), ctx);
+            break;
+        }
+        return 0;
+    }
+
+    static constexpr size_t words = (num_signals + 31) / 32;
+
+    class Planner;
+    class Sequencer;
+
+    static constexpr auto const* pllPath(S s) {
+        for (auto const& p : Clocks::pll_paths)
+            if (p.output == static_cast<Id>(s))
+                return &p;
+        return static_cast<PllPath<Id> const*>(nullptr);
+    }
+
+    static void mark(uint32_t* set, Id id) { set[id >> 5] |= 1u << (id & 31); }
+    static bool isMarked(uint32_t const* set, Id id) { return set[id >> 5] & (1u << (id & 31)); }
+
+    /// Backward sweep of activeClocks(): mark the paths of the running
+    /// leaves in `set`, which must be clear.
+    void markActive(uint32_t const* freqs, uint32_t* set, EvalContext<Id> const& ctx) const {
+        for (size_t i = num_signals; i-- > 0; ) {
+            Id id = Clocks::topo_order[i];
+            bool leaf = Clocks::fanout_offsets[id] == Clocks::fanout_offsets[id + 1];
+            if (freqs[id] == 0 || !(leaf || isMarked(set, id)))
+                continue;
+            mark(set, id);
+            if (Id in = this->selectedInput(id, ctx))
+                mark(set, in);
+        }
+    }
+
+    /// Re-evaluate the subscriptions to affected signals and run the
+    /// callbacks of those whose frequency changed.
+    void notify(uint32_t const* affected) {
+        for (size_t i = 0; i < num_signals; ++i)
+            if (isMarked(affected, Id(i)))
+                this->discard(Id(i));
+        uint32_t freqs[num_signals];
+        uint32_t valid[words] = {};
+        SnapshotBuffer<Clocks::register_words> regs{Clocks::register_base, load, &backend_};
+        EvalContext<Id> ctx{*this, regs};
+        typename Clocks::Memo memo{freqs, valid};
+        for (auto* sub = subs_; sub; ) {
+            auto* next = sub->next;
+            auto id = static_cast<Id>(sub->signal);
+            if (id < num_signals && isMarked(affected, id)) {
+                uint32_t f = Clocks::template getFrequency<Clocks::max_depth>(id, ctx, &memo);
+                if (f != sub->frequency) {
+                    uint32_t old_freq = sub->frequency;
+                    sub->frequency = f;
+                    sub->callback(*sub, old_freq);
+                }
+            }
+            sub = next;
+        }
+    }
+
+    static uint32_t load(void const* backend, uintptr_t addr) {
+        return static_cast<Backend const*>(backend)->read(addr);
+    }
+
+    /// Pending register writes on top of the backend, for evaluateWith().
+    struct Overlay {
+        std::span<RegisterSetting const> settings;
+        Backend const* backend;
+    };
+
+    static uint32_t loadOverlay(void const* overlay, uintptr_t addr) {
+        auto& ov = *static_cast<Overlay const*>(overlay);
+        uint32_t value = ov.backend->read(addr);
+        for (auto& s : ov.settings)
+            if (s.addr == addr)
+                value = (value & ~s.mask) | (s.value & s.mask);
+        return value;
+    }
+
+    [[no_unique_address]] Backend backend_;
+    Subscription<S>* subs_ = nullptr;
+};
+
+/** Backtracking search behind ClockTree::plan().
+ *
+ * The search works on a copy of the clock registers in which every bit is
+ * either still free or fixed by a decision. A goal asks for a signal within
+ * a frequency range. Goals are met one at a time, depth first. A goal whose
+ * signal is already determined by fixed bits is just checked. Otherwise the
+ * element driving it is expanded: a mux tries its inputs, a divider its
+ * factors, each turning the goal into one for the input; a gate gets enabled,
+ * and a PLL places its input first and then picks its factors for the
+ * frequency that input ended up with. A failing branch undoes its decisions
+ * through a trail. Branches are pruned with the range of frequencies each
+ * signal can reach at all, computed once per search from the generated
+ * limits.
+ */
+template<typename Clocks, typename Backend, typename Precision>
+class ClockTree<Clocks, Backend, Precision>::Planner {
+public:
+    /// A signal and the range its frequency has to be in, or with `pll`
+    /// set, the PLL driving the signal, to be set up once its input is.
+    struct Goal {
+        Id          signal;
+        bool        pll;
+        Range       want;
+        Goal const* next;
+    };
+
+    Planner(ClockTree const& tree, uint32_t max_steps) : tree(tree), steps_left_(max_steps) {
+        for (auto& u : Clocks::field_uses) {
+            if (count_ && offset_[count_ - 1] == u.word_offset)
+                continue;
+            offset_[count_] = u.word_offset;
+            value_[count_] = tree.backend_.read(Clocks::register_base + (uintptr_t(u.word_offset) << 2));
+            fixed_[count_++] = 0;
+        }
+        for (size_t i = 0; i < num_signals; ++i)
+            reachable(Clocks::topo_order[i]);
+    }
+
+    /// Meet the requirements, then the goals in `next`.
+    bool solve(std::span<Requirement<S> const> reqs, Goal const* next = nullptr) {
+        if (reqs.empty())
+            return reach(next);
+        auto& r = reqs.back();
+        Goal g{static_cast<Id>(r.signal), false, {r.min, r.max}, next};
+        return solve(reqs.first(reqs.size() - 1), &g);
+    }
+
+    void result(Plan& out) const {
+        out.count = 0;
+        for (uint16_t i = 0; i < count_; ++i)
+            if (fixed_[i])
+                out.settings[out.count++] = {Clocks::register_base + (uintptr_t(offset_[i]) << 2),
+                                             fixed_[i], value_[i] & fixed_[i]};
+    }
+
+    // Context interface of frequencyOf(), noting reads of free bits
+    ClockTree const& tree;
+
+    uint32_t bit(BitAddr a) const { return field({a.word_offset, a.bit, 1}); }
+
+    uint32_t field(FieldAddr a) const {
+        uint16_t i = slot(a.word_offset);
+        uint32_t m = ((1u << a.width) - 1) << a.bit;
+        if (i == count_)
+            return 0;
+        if ((fixed_[i] & m) != m)
+            free_read_ = true;
+        return (value_[i] & m) >> a.bit;
+    }
+
+private:
+    static constexpr Range none{1, 0};
+
+    /// A fixed register word as it was before a decision.
+    struct TrailEntry {
+        uint16_t slot;
+        uint32_t value;
+        uint32_t fixed;
+    };
+
+    static constexpr uint32_t sat(uint64_t v) { return v > 0xFFFFFFFF ? 0xFFFFFFFF : uint32_t(v); }
+    static constexpr Range meet(Range a, Range b) {
+        return {a.min > b.min ? a.min : b.min, a.max < b.max ? a.max : b.max};
+    }
+    static constexpr bool empty(Range r) { return r.min > r.max; }
+    /// Input frequencies for which an output in `r` results from dividing by d.
+    static constexpr Range times(Range r, uint32_t d) {
+        return {sat(uint64_t(r.min) * d), sat(uint64_t(r.max) * d + d - 1)};
+    }
+
+    uint16_t slot(uint32_t word_offset) const {
+        uint16_t i = 0;
+        while (i < count_ && offset_[i] != word_offset)
+            ++i;
+        return i;
+    }
+
+    uint32_t frequency(Id id) const { return tree.frequencyOf(id, *this); }
+
+    /// Fix a register field to `v`; fails if it is already fixed to another value.
+    bool fix(FieldAddr a, uint32_t v) {
+        uint16_t i = slot(a.word_offset);
+        uint32_t m = ((1u << a.width) - 1) << a.bit;
+        if (i == count_ || ((v << a.bit) & ~m))
+            return false;
+        if (((value_[i] ^ (v << a.bit)) & fixed_[i] & m))
+            return false;
+        if ((fixed_[i] & m) == m)
+            return true;
+        trail_[depth_++] = {i, value_[i], fixed_[i]};
+        value_[i] = (value_[i] & ~m) | (v << a.bit);
+        fixed_[i] |= m;
+        return true;
+    }
+
+    bool fix(BitAddr a, uint32_t v) { return fix(FieldAddr{a.word_offset, a.bit, 1}, v); }
+
+    void undo(uint16_t mark) {
+        while (depth_ > mark) {
+            auto& e = trail_[--depth_];
+            value_[e.slot] = e.value;
+            fixed_[e.slot] = e.fixed;
+        }
+    }
+
+    /// Follow goal `g` after fixing field `a` to `v`, undoing the fix on failure.
+    bool tryFix(FieldAddr a, uint32_t v, Goal const& g) {
+        uint16_t mark = depth_;
+        if (fix(a, v) && reach(&g))
+            return true;
+        undo(mark);
+        return false;
+    }
+
+    /// Range of a factor field: raw values 0..2^width-1 plus offset.
+    static constexpr Range factors(FieldAddr a, uint8_t offset) {
+        return {offset, ((1u << a.width) - 1) + offset};
+    }
+
+    /// Frequencies signal `id` can reach in any configuration, from those
+    /// of its inputs, ignoring that paths may share elements.
+    void reachable(Id id) {
+        auto sig = Clocks::signal_table[id];
+        Id const* in = &Clocks::input_pool_data[sig.input_offset];
+        Range r = none;
+        if (sig.type != 0) {
+            switch (Clocks::type_table[sig.type].kind) {
+            case Kind::Gate:
+            case Kind::GateInv:
+            case Kind::Passthrough:
+                r = reach_[in[0]];
+                break;
+            case Kind::GenFixed:
+                if constexpr (requires { Clocks::gen_fixed_descs; }) {
+                    uint32_t f = Clocks::gen_fixed_descs[sig.desc_index].frequency;
+                    r = {f, f};
+                }
+                break;
+            case Kind::GenExternal:
+                if constexpr (requires { Clocks::gen_external_descs; }) {
+                    uint32_t f = tree.state[Clocks::gen_external_descs[sig.desc_index].state_slot];
+                    r = {f, f};
+                }
+                break;
+            case Kind::TableDiv:
+                if constexpr (requires { Clocks::table_div_descs; }) {
+                    auto& d = Clocks::table_div_descs[sig.desc_index];
+                    for (uint8_t k = 0; k < d.table_size; ++k)
+                        r = join(r, divided(reach_[in[0]], tree.value_tables[d.table_offset + k]));
+                }
+                break;
+            case Kind::LinearDiv:
+                if constexpr (requires { Clocks::linear_div_descs; }) {
+                    auto& d = Clocks::linear_div_descs[sig.desc_index];
+                    Range f = factors(d.field, d.offset);
+                    r = join(divided(reach_[in[0]], f.max), divided(reach_[in[0]], f.min ? f.min : 1));
+                }
+                break;
+            case Kind::FixedDiv:
+                if constexpr (requires { Clocks::fixed_div_descs; })
+                    r = divided(reach_[in[0]], Clocks::fixed_div_descs[sig.desc_index].divisor);
+                break;
+            case Kind::FracDiv:
+                if constexpr (requires { Clocks::frac_div_descs; }) {
+                    auto& d = Clocks::frac_div_descs[sig.desc_index];
+                    Range f = factors(d.factor, 0);
+                    uint32_t lo = d.frac_bits ? (f.min ? f.min : 1) : (d.base ? d.base : 1);
+                    uint32_t hi = d.frac_bits ? f.max + 1 : d.base + f.max / (d.offset ? d.offset : 1) + 1;
+                    r = join(divided(reach_[in[0]], hi), divided(reach_[in[0]], lo));
+                }
+                break;
+            case Kind::Mux:
+                if constexpr (requires { Clocks::mux_descs; })
+                    for (uint8_t k = 0; k < Clocks::mux_descs[sig.desc_index].input_count; ++k)
+                        if (in[k])
+                            r = join(r, reach_[in[k]]);
+                break;
+            case Kind::Pll:
+                if constexpr (requires { Clocks::pll_descs; }) {
+                    auto f = pllFactors(id);
+                    Range src = meet(reach_[in[0]], Clocks::limits[in[0]]);
+                    if (!empty(src)) {
+                        Range vco = meet({sat(uint64_t(src.min) * f.n.min >> f.frac_bits),
+                                          sat(uint64_t(src.max) * f.n.max >> f.frac_bits)}, f.vco);
+                        r = join(divided(vco, f.post.max), divided(vco, f.post.min));
+                    }
+                }
+                break;
+            }
+        }
+        reach_[id] = meet(r, Clocks::limits[id]);
+    }
+
+    static constexpr Range join(Range a, Range b) {
+        if (empty(a)) return b;
+        if (empty(b)) return a;
+        return {a.min < b.min ? a.min : b.min, a.max > b.max ? a.max : b.max};
+    }
+
+    static constexpr Range divided(Range r, uint32_t d) {
+        return empty(r) || !d ? none : Range{r.min / d, r.max / d};
+    }
+
+    /// Factor ranges of a PLL, from its solver path if there is one.
+    struct PllFactors {
+        Range   n;              ///< Feedback factor in units of 2^-frac_bits
+        Range   frac;           ///< Raw fraction
+        Range   post;
+        Range   vco;
+        uint8_t frac_bits;
+    };
+
+    PllFactors pllFactors(Id id) const {
+        auto& p = Clocks::pll_descs[Clocks::signal_table[id].desc_index];
+        Range fb = factors(p.fb_int, p.fb_int_offset);
+        Range frac = p.fb_frac.width ? factors(p.fb_frac, 0) : Range{0, 0};
+        Range post = p.post_div.width ? factors(p.post_div, p.post_div_offset) : Range{1, 1};
+        Range vco = {0, 0xFFFFFFFF};
+        if constexpr (requires { Clocks::pll_paths; }) {
+            for (auto& path : Clocks::pll_paths) {
+                if (path.output == id) {
+                    fb = path.fb_int_range;
+                    frac = path.fb_frac_range;
+                    post = path.post_div_range;
+                    vco = path.vco_freq;
+                }
+            }
+        }
+        if (!post.min)
+            post.min = 1;
+        return {{sat((uint64_t(fb.min) << p.frac_bits) + frac.min), sat((uint64_t(fb.max) << p.frac_bits) + frac.max)},
+                frac, post, vco, p.frac_bits};
+    }
+
+    bool reach(Goal const* g) {
+        if (!g)
+            return true;
+        if (!steps_left_)
+            return false;
+        --steps_left_;
+        Id id = g->signal;
+        Range want = meet(g->want, Clocks::limits[id]);
+        if (empty(want))
+            return false;
+        if (g->pll)
+            return placePll(id, want, g->next);
+        if (empty(meet(want, reach_[id])))
+            return false;
+
+        // Already determined by fixed bits?
+        free_read_ = false;
+        uint32_t f = frequency(id);
+        if (!free_read_)
+            return f >= want.min && f <= want.max && reach(g->next);
+
+        auto sig = Clocks::signal_table[id];
+        Id const* in = &Clocks::input_pool_data[sig.input_offset];
+        switch (Clocks::type_table[sig.type].kind) {
+        case Kind::Gate:
+            if constexpr (requires { Clocks::gate_descs; }) {
+                auto& d = Clocks::gate_descs[sig.desc_index];
+                return tryFix({d.addr.word_offset, d.addr.bit, 1}, 1, {in[0], false, want, g->next});
+            }
+            break;
+        case Kind::GateInv:
+            if constexpr (requires { Clocks::gate_inv_descs; }) {
+                auto& d = Clocks::gate_inv_descs[sig.desc_index];
+                return tryFix({d.addr.word_offset, d.addr.bit, 1}, 0, {in[0], false, want, g->next});
+            }
+            break;
+        case Kind::Passthrough: {
+            Goal n{in[0], false, want, g->next};
+            return reach(&n);
+        }
+        case Kind::GenFixed:
+            if constexpr (requires { Clocks::gen_fixed_descs; }) {
+                auto& d = Clocks::gen_fixed_descs[sig.desc_index];
+                return tryFix({d.addr.word_offset, d.addr.bit, 1}, d.polarity != Polarity::ActiveLow, *g);
+            }
+            break;
+        case Kind::GenExternal:
+            if constexpr (requires { Clocks::gen_external_descs; }) {
+                auto& d = Clocks::gen_external_descs[sig.desc_index];
+                return tryFix({d.addr.word_offset, d.addr.bit, 1}, d.polarity != Polarity::ActiveLow, *g);
+            }
+            break;
+        case Kind::TableDiv:
+            if constexpr (requires { Clocks::table_div_descs; }) {
+                auto& d = Clocks::table_div_descs[sig.desc_index];
+                for (uint8_t k = 0; k < d.table_size; ++k) {
+                    uint32_t div = tree.value_tables[d.table_offset + k];
+                    Range r = div ? meet(times(want, div), reach_[in[0]]) : none;
+                    if (!empty(r) && tryFix(d.field, k, {in[0], false, r, g->next}))
+                        return true;
+                }
+            }
+            break;
+        case Kind::LinearDiv:
+            if constexpr (requires { Clocks::linear_div_descs; }) {
+                auto& d = Clocks::linear_div_descs[sig.desc_index];
+                Range f = factors(d.field, d.offset);
+                for (uint32_t div = f.min ? f.min : 1; div <= f.max; ++div) {
+                    if (uint64_t(want.min) * div > reach_[in[0]].max)
+                        break;
+                    Range r = meet(times(want, div), reach_[in[0]]);
+                    if (!empty(r) && tryFix(d.field, div - d.offset, {in[0], false, r, g->next}))
+                        return true;
+                }
+            }
+            break;
+        case Kind::FixedDiv:
+            if constexpr (requires { Clocks::fixed_div_descs; }) {
+                Goal n{in[0], false, times(want, Clocks::fixed_div_descs[sig.desc_index].divisor), g->next};
+                return reach(&n);
+            }
+            break;
+        case Kind::FracDiv:
+            // Integer divisors only: the fraction, or the numerator of a
+            // ratio, is set to 0
+            if constexpr (requires { Clocks::frac_div_descs; }) {
+                auto& d = Clocks::frac_div_descs[sig.desc_index];
+                uint16_t mark = depth_;
+                if (!d.frac_bits) {
+                    Range r = d.base ? meet(times(want, d.base), reach_[in[0]]) : none;
+                    if (!empty(r) && tryFix(d.factor, 0, {in[0], false, r, g->next}))
+                        return true;
+                    break;
+                }
+                Range f = factors(d.factor, 0);
+                for (uint32_t div = f.min ? f.min : 1; div <= f.max; ++div) {
+                    if (uint64_t(want.min) * div > reach_[in[0]].max)
+                        break;
+                    Range r = meet(times(want, div), reach_[in[0]]);
+                    if (!empty(r) && fix(d.denominator, 0) && tryFix(d.factor, div, {in[0], false, r, g->next}))
+                        return true;
+                    undo(mark);
+                }
+            }
+            break;
+        case Kind::Mux:
+            if constexpr (requires { Clocks::mux_descs; }) {
+                auto& d = Clocks::mux_descs[sig.desc_index];
+                for (uint8_t k = 0; k < d.input_count; ++k)
+                    if (in[k] && !empty(meet(want, reach_[in[k]])) && tryFix(d.field, k, {in[k], false, want, g->next}))
+                        return true;
+            }
+            break;
+        case Kind::Pll:
+            if constexpr (requires { Clocks::pll_descs; }) {
+                // Place the input of the reference divider, if any, then
+                // pick the factors along with the reference divider
+                Id src = refDivider(id) ? Clocks::input_pool_data[Clocks::signal_table[in[0]].input_offset] : in[0];
+                Goal pll{id, true, want, g->next};
+                Goal n{src, false, reach_[src], &pll};
+                return reach(&n);
+            }
+            break;
+        }
+        return false;
+    }
+
+    /// The linear divider driving the input of the PLL driving `id`, if any.
+    static constexpr LinearDivDesc const* refDivider(Id id) {
+        if constexpr (requires { Clocks::linear_div_descs; }) {
+            auto ref = Clocks::signal_table[Clocks::input_pool_data[Clocks::signal_table[id].input_offset]];
+            if (ref.type && Clocks::type_table[ref.type].kind == Kind::LinearDiv)
+                return &Clocks::linear_div_descs[ref.desc_index];
+        }
+        return nullptr;
+    }
+
+    /** Pick the factors of the PLL driving `id`, and of its reference
+     * divider, for an output in `want`, with the input frequency already
+     * determined, then go on with `next`.
+     *
+     * Settings that give the same VCO and output frequencies are equivalent
+     * for the rest of the tree, so only the first of them is tried.
+     */
+    bool placePll(Id id, Range want, Goal const* next) {
+        if constexpr (requires { Clocks::pll_descs; }) {
+            auto& p = Clocks::pll_descs[Clocks::signal_table[id].desc_index];
+            auto f = pllFactors(id);
+            Id in0 = Clocks::input_pool_data[Clocks::signal_table[id].input_offset];
+            auto const* ref = refDivider(id);
+            uint64_t in = frequency(ref ? Clocks::input_pool_data[Clocks::signal_table[in0].input_offset] : in0);
+            if (!in)
+                return false;
+            free_read_ = false;
+            uint32_t out = frequency(id);
+            if (!free_read_)
+                return out >= want.min && out <= want.max && reach(next);
+
+            Setting tried[max_tried];
+            unsigned num_tried = 0;
+            Range ms = ref ? factors(ref->field, ref->offset) : Range{1, 1};
+            uint64_t one = uint64_t(1) << f.frac_bits;
+            for (uint32_t m = ms.min ? ms.min : 1; m <= ms.max; ++m) {
+                uint32_t ref_freq = uint32_t(in / m);
+                if (ref_freq < Clocks::limits[in0].min)
+                    break;
+                if (ref_freq > Clocks::limits[in0].max)
+                    continue;
+                uint16_t ref_mark = depth_;
+                if (ref && !fix(ref->field, m - ref->offset))
+                    continue;
+                for (uint32_t d = f.post.min; d <= f.post.max; ++d) {
+                    Range vco = meet(times(want, d), f.vco);
+                    if (empty(vco))
+                        continue;
+                    // Feedback factors that put the VCO into that range
+                    uint64_t n_lo = (uint64_t(vco.min) * one + ref_freq - 1) / ref_freq;
+                    uint64_t n_hi = ((uint64_t(vco.max) + 1) * one - 1) / ref_freq;
+                    if (n_lo < f.n.min) n_lo = f.n.min;
+                    if (n_hi > f.n.max) n_hi = f.n.max;
+                    if (n_lo > n_hi)
+                        continue;
+                    // Candidates: the middle integer factor, a spread of further
+                    // integer factors, and the exact middle with a fraction
+                    uint64_t cand[pll_candidates + 2];
+                    unsigned count = 0;
+                    uint64_t lo = (n_lo + one - 1) / one, hi = n_hi / one;
+                    if (lo <= hi) {
+                        uint64_t step = (hi - lo) / pll_candidates + 1;
+                        cand[count++] = (lo + hi) / 2 * one;
+                        for (uint64_t i = lo; i <= hi && count <= pll_candidates; i += step)
+                            if (i * one != cand[0])
+                                cand[count++] = i * one;
+                    }
+                    if (f.frac_bits)
+                        cand[count++] = (n_lo + n_hi) / 2;
+                    for (unsigned k = 0; k < count; ++k) {
+                        uint32_t frac = uint32_t(cand[k] % one);
+                        if (frac < f.frac.min || frac > f.frac.max)
+                            continue;
+                        uint16_t mark = depth_;
+                        if (fix(p.fb_int, uint32_t(cand[k] / one) - p.fb_int_offset)
+                                && (!p.fb_frac.width || fix(p.fb_frac, frac))
+                                && (!p.post_div.width || fix(p.post_div, d - p.post_div_offset))) {
+                            out = frequency(id);
+                            if (out >= want.min && out <= want.max
+                                    && !seen(tried, num_tried, {uint32_t(ref_freq * cand[k] / one), out})
+                                    && reach(next))
+                                return true;
+                        }
+                        undo(mark);
+                    }
+                }
+                undo(ref_mark);
+            }
+        }
+        return false;
+    }
+
+    /// VCO and output frequency of a PLL setting.
+    struct Setting {
+        uint32_t vco;
+        uint32_t out;
+    };
+
+    /// Look `v` up in the first `count` entries of `set`, adding it if
+    /// missing and there is room.
+    static bool seen(Setting* set, unsigned& count, Setting v) {
+        for (unsigned i = 0; i < count; ++i)
+            if (set[i].vco == v.vco && set[i].out == v.out)
+                return true;
+        if (count < max_tried)
+            set[count++] = v;
+        return false;
+    }
+
+    /// PLL settings remembered per placement.
+    static constexpr unsigned max_tried = 64;
+
+    /// Integer feedback factors tried per post-divider setting.
+    static constexpr unsigned pll_candidates = 8;
+
+    uint32_t         steps_left_;
+    mutable bool     free_read_ = false;
+    uint16_t         count_ = 0;
+    uint16_t         depth_ = 0;
+    uint32_t         offset_[Clocks::register_words];
+    uint32_t         value_[Clocks::register_words];
+    uint32_t         fixed_[Clocks::register_words];
+    TrailEntry       trail_[Clocks::register_words * 32];
+    Range            reach_[num_signals];
+};
+
+/** Greedy scheduler behind ClockTree::sequence().
+ *
+ * The sequencer works on a copy of the clock registers, starting from their
+ * current contents, and keeps the frequencies and running paths they give.
+ * A stopped PLL evaluates to 0 until it is started again. The target is
+ * split into changes, one per element field that differs. A change is
+ * applied, together with other changes of the same register, as soon as the
+ * result is safe. When none is, a mux or gate between a PLL still to be
+ * changed and a running leaf clock is moved out of the way, and a change
+ * that restores it is queued.
+ */
+template<typename Clocks, typename Backend, typename Precision>
+class ClockTree<Clocks, Backend, Precision>::Sequencer {
+public:
+    Sequencer(ClockTree const& tree, std::span<S const> watch, Sequence& out)
+        : tree_{tree}, watch_{watch}, out_{out}, regs_{Clocks::register_base, load, &tree.backend_} {}
+
+    bool run(std::span<RegisterSetting const> target) {
+        out_.count = 0;
+        if (!split(target))
+            return false;
+        finalState(target);
+        evaluate(freqs_, active_);
+        violations(freqs_, viol_);
+        blocked(pend_);
+        exposed(pend_, active_, exposed_);
+        for (;;) {
+            bool progress = false, finished = true;
+            for (uint16_t i = 0; i < num_changes_; ++i) {
+                if (changes_[i].done)
+                    continue;
+                if (apply(changes_[i]))
+                    progress = true;
+                else
+                    finished = false;
+            }
+            if (overflow_)
+                return false;
+            if (finished)
+                return !intersects(stopped_, final_);
+            if (!progress && !detour())
+                return false;
+        }
+    }
+
+private:
+    /// Bits of one element to be written.
+    struct Change {
+        RegisterSetting write;
+        Id              signal;     ///< Element reading the bits, 0 if none
+        bool            done;
+    };
+
+    static constexpr size_t max_changes = sizeof(Clocks::field_uses) / sizeof(Clocks::field_uses[0]) + num_signals;
+
+    static Kind kind(Id id) { return Clocks::type_table[Clocks::signal_table[id].type].kind; }
+
+    static bool intersects(uint32_t const* a, uint32_t const* b) {
+        for (size_t w = 0; w < words; ++w)
+            if (a[w] & b[w])
+                return true;
+        return false;
+    }
+
+    /// Word at `offset` in the working copy, null if the tree has no
+    /// fields there.
+    uint32_t* word(uint32_t offset) {
+        bool used = false;
+        for (auto& u : Clocks::field_uses)
+            used |= u.word_offset == offset;
+        if (!used)
+            return nullptr;
+        regs_.word(offset);
+        for (uint16_t i = 0; i < regs_.count; ++i)
+            if (regs_.entries[i].word_offset == offset)
+                return &regs_.entries[i].value;
+        return nullptr;
+    }
+
+    uint32_t* wordAt(uintptr_t addr) { return word(uint32_t((addr - Clocks::register_base) >> 2)); }
+
+    /// Split the target into changes of the bits each element reads.
+    bool split(std::span<RegisterSetting const> target) {
+        for (auto& t : target) {
+            uint32_t* w = wordAt(t.addr);
+            if (!w)
+                return false;
+            uint32_t offset = uint32_t((t.addr - Clocks::register_base) >> 2);
+            uint32_t rest = t.mask;
+            for (auto& u : Clocks::field_uses) {
+                if (u.word_offset == offset && (u.mask & rest)) {
+                    if (!add({t.addr, u.mask & rest, t.value & u.mask & rest}, u.signal, *w))
+                        return false;
+                    rest &= ~u.mask;
+                }
+            }
+            if (rest && !add({t.addr, rest, t.value & rest}, 0, *w))
+                return false;
+        }
+        return true;
+    }
+
+    bool add(RegisterSetting write, Id signal, uint32_t current) {
+        if ((current & write.mask) == write.value)
+            return true;
+        if (num_changes_ == max_changes)
+            return false;
+        changes_[num_changes_++] = {write, signal, false};
+        return true;
+    }
+
+    /// Record the signals running in the target configuration.
+    void finalState(std::span<RegisterSetting const> target) {
+        Overlay ov{target, &tree_.backend_};
+        SnapshotBuffer<Clocks::register_words> regs{Clocks::register_base, loadOverlay, &ov};
+        EvalContext<Id> ctx{tree_, regs};
+        uint32_t freqs[num_signals];
+        tree_.sweep(freqs, ctx);
+        tree_.markActive(freqs, final_, ctx);
+    }
+
+    /// Frequencies and running paths of the working copy.
+    void evaluate(uint32_t* freqs, uint32_t* active) {
+        EvalContext<Id> ctx{tree_, regs_};
+        tree_.sweep(freqs, ctx, stopped_);
+        for (size_t w = 0; w < words; ++w)
+            active[w] = 0;
+        tree_.markActive(freqs, active, ctx);
+    }
+
+    static void violations(uint32_t const* freqs, uint32_t* set) {
+        for (size_t w = 0; w < words; ++w)
+            set[w] = 0;
+        for (size_t i = 0; i < num_signals; ++i)
+            if (freqs[i] != 0 && (freqs[i] < Clocks::limits[i].min || freqs[i] > Clocks::limits[i].max))
+                mark(set, Id(i));
+    }
+
+    /// Mark the PLLs whose output changes with the element driving `sig`:
+    /// those it feeds through the selected inputs, and the PLL right in
+    /// front of it if it is a divider.
+    void touched(Id sig, uint32_t* plls) {
+        if (sig == 0)
+            return;
+        EvalContext<Id> ctx{tree_, regs_};
+        for (size_t i = 1; i < num_signals; ++i) {
+            if (kind(Id(i)) != Kind::Pll)
+                continue;
+            for (Id x = Id(i); x != 0; x = tree_.selectedInput(x, ctx)) {
+                if (x == sig) {
+                    mark(plls, Id(i));
+                    break;
+                }
+            }
+        }
+        if (kind(sig) == Kind::LinearDiv || kind(sig) == Kind::TableDiv || kind(sig) == Kind::FracDiv) {
+            Id in = Clocks::input_pool_data[Clocks::signal_table[sig].input_offset];
+            if (kind(in) == Kind::Pll)
+                mark(plls, in);
+        }
+    }
+
+    /// PLLs that must not feed a running clock: those with changes left,
+    /// and those stopped and not started again.
+    void blocked(uint32_t* plls) {
+        for (size_t w = 0; w < words; ++w)
+            plls[w] = stopped_[w];
+        for (uint16_t i = 0; i < num_changes_; ++i)
+            if (!changes_[i].done)
+                touched(changes_[i].signal, plls);
+    }
+
+    /// Running signals fed by a blocked PLL through the selected inputs.
+    void exposed(uint32_t const* pend, uint32_t const* active, uint32_t* set) {
+        EvalContext<Id> ctx{tree_, regs_};
+        for (size_t w = 0; w < words; ++w)
+            set[w] = 0;
+        for (size_t i = 0; i < num_signals; ++i) {
+            Id id = Clocks::topo_order[i];
+            Id in = tree_.selectedInput(id, ctx);
+            if (isMarked(pend, id) || (in != 0 && isMarked(set, in)))
+                mark(set, id);
+        }
+        for (size_t w = 0; w < words; ++w)
+            set[w] &= active[w];
+    }
+
+    /// Evaluate the working copy and check that it adds no limit violation
+    /// and no running clock fed by a blocked PLL.
+    bool safe(uint32_t* freqs, uint32_t* active, uint32_t* pend, uint32_t* exp) {
+        uint32_t viol[words];
+        evaluate(freqs, active);
+        violations(freqs, viol);
+        blocked(pend);
+        exposed(pend, active, exp);
+        for (size_t w = 0; w < words; ++w)
+            if ((viol[w] & ~viol_[w]) || (exp[w] & ~exposed_[w]))
+                return false;
+        return true;
+    }
+
+    /// Whether a running clock that the target keeps running would stop.
+    bool interrupts(uint32_t const* freqs) {
+        for (size_t i = 0; i < num_signals; ++i)
+            if (isMarked(active_, Id(i)) && isMarked(final_, Id(i)) && freqs[i] == 0)
+                return true;
+        return false;
+    }
+
+    /// Stop the PLLs in `plls` that still run, for a trial write; returns
+    /// them in `fresh`.
+    void stop(uint32_t const* plls, uint32_t* fresh) {
+        for (size_t w = 0; w < words; ++w) {
+            fresh[w] = plls[w] & ~stopped_[w];
+            stopped_[w] |= fresh[w];
+        }
+    }
+
+    void unstop(uint32_t const* fresh) {
+        for (size_t w = 0; w < words; ++w)
+            stopped_[w] &= ~fresh[w];
+    }
+
+    /// Apply a change, and other changes of the same register with it, if
+    /// that is safe.
+    bool apply(Change& c) {
+        uint32_t* w = wordAt(c.write.addr);
+        if ((*w & c.write.mask) == c.write.value) {
+            c.done = true;
+            blocked(pend_);
+            exposed(pend_, active_, exposed_);
+            return true;
+        }
+        uint32_t plls[words] = {}, fresh[words];
+        touched(c.signal, plls);
+        if (intersects(plls, active_))
+            return false;
+        uint32_t freqs[num_signals], active[words], pend[words], exp[words];
+        uint32_t old = *w;
+        stop(plls, fresh);
+        *w = (old & ~c.write.mask) | c.write.value;
+        c.done = true;
+        if (!safe(freqs, active, pend, exp) || interrupts(freqs) || onBlocked(c.signal, exp)) {
+            *w = old;
+            c.done = false;
+            unstop(fresh);
+            return false;
+        }
+        RegisterSetting write = c.write;
+        for (uint16_t i = 0; i < num_changes_; ++i) {
+            Change& d = changes_[i];
+            if (d.done || d.write.addr != write.addr)
+                continue;
+            if ((*w & d.write.mask) == d.write.value) {
+                d.done = true;
+                continue;
+            }
+            uint32_t more[words] = {}, extra[words];
+            touched(d.signal, more);
+            if (intersects(more, active_))
+                continue;
+            uint32_t before = *w;
+            stop(more, extra);
+            *w = (before & ~d.write.mask) | d.write.value;
+            d.done = true;
+            if (!safe(freqs, active, pend, exp) || interrupts(freqs) || onBlocked(d.signal, exp)) {
+                *w = before;
+                d.done = false;
+                unstop(extra);
+                safe(freqs, active, pend, exp);
+                continue;
+            }
+            for (size_t k = 0; k < words; ++k)
+                fresh[k] |= extra[k];
+            write.mask |= d.write.mask;
+            write.value = (write.value & ~d.write.mask) | d.write.value;
+        }
+        commit(write, c.signal, fresh, freqs, active);
+        return true;
+    }
+
+    /// Move a running mux or gate on the path from a blocked PLL out of
+    /// the way. A mux is preferably switched to another running input that
+    /// the target leaves alone, one fed by an oscillator without a PLL
+    /// first, then to any running input. The last resort is a gate closed
+    /// or a mux switched to a stopped input.
+    bool detour() {
+        enum Pass { Oscillator, Untouched, Running, Stop };
+        for (Pass pass : {Oscillator, Untouched, Running, Stop}) {
+            bool stop = pass == Stop;
+            for (size_t i = 0; i < num_signals; ++i) {
+                Id id = Clocks::topo_order[i];
+                if (!isMarked(exposed_, id) || isMarked(moved_, id) || isMarked(pend_, id))
+                    continue;
+                auto sig = Clocks::signal_table[id];
+                switch (kind(id)) {
+                case Kind::Mux:
+                    if constexpr (requires { Clocks::mux_descs; }) {
+                        auto& d = Clocks::mux_descs[sig.desc_index];
+                        for (uint32_t j = 0; j < d.input_count; ++j) {
+                            Id in = Clocks::input_pool_data[sig.input_offset + j];
+                            if (pass < Running && !settled(in, pass == Oscillator))
+                                continue;
+                            if (move(id, d.field, j, !stop))
+                                return true;
+                        }
+                    }
+                    break;
+                case Kind::Gate:
+                    if constexpr (requires { Clocks::gate_descs; }) {
+                        auto a = Clocks::gate_descs[sig.desc_index].addr;
+                        if (stop && move(id, {a.word_offset, a.bit, 1}, 0, false))
+                            return true;
+                    }
+                    break;
+                case Kind::GateInv:
+                    if constexpr (requires { Clocks::gate_inv_descs; }) {
+                        auto a = Clocks::gate_inv_descs[sig.desc_index].addr;
+                        if (stop && move(id, {a.word_offset, a.bit, 1}, 1, false))
+                            return true;
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        return false;
+    }
+
+    /// Whether mux `id` would select an input fed by a blocked PLL, so it
+    /// is better switched once that PLL is done.
+    static bool onBlocked(Id id, uint32_t const* exp) {
+        return id != 0 && kind(id) == Kind::Mux && isMarked(exp, id);
+    }
+
+    /// Whether the target leaves the path from signal `in` to its source
+    /// alone: no element on it has a change left. With `oscillator`, the
+    /// path must not contain a PLL either.
+    bool settled(Id in, bool oscillator) {
+        EvalContext<Id> ctx{tree_, regs_};
+        for (Id x = in; x != 0; x = tree_.selectedInput(x, ctx)) {
+            if (isMarked(pend_, x) || (oscillator && kind(x) == Kind::Pll))
+                return false;
+            for (uint16_t i = 0; i < num_changes_; ++i)
+                if (!changes_[i].done && changes_[i].signal == x)
+                    return false;
+        }
+        return in != 0;
+    }
+
+    /// Set field `a` of element `id` to `value` if that is safe and takes
+    /// the element off the blocked PLLs, and queue a change restoring it.
+    /// Elements in front of a PLL are not moved.
+    bool move(Id id, FieldAddr a, uint32_t value, bool running) {
+        uint32_t* w = word(a.word_offset);
+        if (!w)
+            return false;
+        uint32_t mask = ((1u << a.width) - 1) << a.bit;
+        uint32_t old = *w;
+        if ((old & mask) == value << a.bit)
+            return false;
+        uint32_t plls[words] = {}, none[words] = {};
+        touched(id, plls);
+        for (uint32_t p : plls)
+            if (p)
+                return false;
+        uint32_t freqs[num_signals], active[words], pend[words], exp[words];
+        *w = (old & ~mask) | (value << a.bit);
+        if (!safe(freqs, active, pend, exp) || isMarked(exp, id) || (running && freqs[id] == 0)) {
+            *w = old;
+            return false;
+        }
+        uintptr_t addr = Clocks::register_base + (uintptr_t(a.word_offset) << 2);
+        bool queued = false;
+        for (uint16_t i = 0; i < num_changes_; ++i)
+            queued |= !changes_[i].done && changes_[i].write.addr == addr && (changes_[i].write.mask & mask);
+        if (!queued) {
+            if (num_changes_ == max_changes) {
+                *w = old;
+                return false;
+            }
+            changes_[num_changes_++] = {{addr, mask, old & mask}, id, false};
+        }
+        mark(moved_, id);
+        commit({addr, mask, value << a.bit}, id, none, freqs, active);
+        return true;
+    }
+
+    /// Emit the steps of a write, which is already applied to the working
+    /// copy together with stopping the PLLs in `plls`, and take over its
+    /// state.
+    void commit(RegisterSetting write, Id signal, uint32_t const* plls, uint32_t const* freqs,
+                uint32_t const* active) {
+        raise(freqs);
+        for (size_t i = 1; i < num_signals; ++i)
+            if (isMarked(plls, Id(i)))
+                emit(Step<S>::Action::StopPll, Id(i), 0);
+        emit(Step<S>::Action::Write, signal, freqs[signal], write);
+        lower(freqs);
+        take(freqs, active);
+        start();
+    }
+
+    /// Start the stopped PLLs without changes left that the target uses,
+    /// each once that is safe.
+    void start() {
+        uint32_t left[words] = {};
+        for (uint16_t i = 0; i < num_changes_; ++i)
+            if (!changes_[i].done)
+                touched(changes_[i].signal, left);
+        for (size_t i = 1; i < num_signals; ++i) {
+            if (!isMarked(stopped_, Id(i)) || isMarked(left, Id(i)) || !isMarked(final_, Id(i)))
+                continue;
+            uint32_t freqs[num_signals], active[words], pend[words], exp[words];
+            stopped_[i >> 5] &= ~(1u << (i & 31));
+            if (!safe(freqs, active, pend, exp) || interrupts(freqs)) {
+                mark(stopped_, Id(i));
+                continue;
+            }
+            raise(freqs);
+            emit(Step<S>::Action::StartPll, Id(i), freqs[i]);
+            lower(freqs);
+            take(freqs, active);
+        }
+    }
+
+    void raise(uint32_t const* freqs) {
+        for (S s : watch_)
+            if (freqs[Id(s)] > freqs_[Id(s)])
+                emit(Step<S>::Action::Raise, Id(s), freqs[Id(s)]);
+    }
+
+    void lower(uint32_t const* freqs) {
+        for (S s : watch_)
+            if (freqs[Id(s)] < freqs_[Id(s)])
+                emit(Step<S>::Action::Lower, Id(s), freqs[Id(s)]);
+    }
+
+    void take(uint32_t const* freqs, uint32_t const* active) {
+        for (size_t i = 0; i < num_signals; ++i)
+            freqs_[i] = freqs[i];
+        for (size_t w = 0; w < words; ++w)
+            active_[w] = active[w];
+        blocked(pend_);
+        exposed(pend_, active_, exposed_);
+    }
+
+    void emit(typename Step<S>::Action action, Id signal, uint32_t frequency, RegisterSetting write = {}) {
+        if (out_.count == sizeof(out_.steps) / sizeof(out_.steps[0])) {
+            overflow_ = true;
+            return;
+        }
+        out_.steps[out_.count++] = {action, static_cast<S>(signal), frequency, write};
+    }
+
+    ClockTree const&  tree_;
+    std::span<S const> watch_;
+    Sequence&         out_;
+    SnapshotBuffer<Clocks::register_words> regs_;
+    bool              overflow_ = false;
+    uint16_t          num_changes_ = 0;
+    Change            changes_[max_changes];
+    uint32_t          freqs_[num_signals];
+    uint32_t          active_[words] = {};
+    uint32_t          viol_[words] = {};
+    uint32_t          pend_[words] = {};
+    uint32_t          exposed_[words] = {};
+    uint32_t          stopped_[words] = {};
+    uint32_t          moved_[words] = {};
+    uint32_t          final_[words] = {};
+};
+
+/** ClockTree with a per-signal frequency cache in RAM.
+ *
+ * Repeated queries of a signal, and of the intermediate signals on its path,
+ * cost a single table lookup until invalidate() is called. The cache can't
+ * see register writes, so code that reprograms the clock tree must call
+ * invalidate() afterwards, or update() to drop just the signals affected by
+ * the write. Costs 6 bytes of RAM per signal.
+ */
+template<typename Clocks, typename Backend = MmioBackend>
+class CachedClockTree : public ClockTree<Clocks, Backend> {
+public:
+    template<typename... Args>
+    CachedClockTree(Args&&... args) : ClockTree<Clocks, Backend>(std::forward<Args>(args)...) {
+        this->cache_freq = freq_;
+        this->cache_epoch = epoch_;
+    }
+
+    CachedClockTree(CachedClockTree const&) = delete;
+    CachedClockTree& operator=(CachedClockTree const&) = delete;
+
+private:
+    static constexpr size_t N = ClockTree<Clocks, Backend>::num_signals;
+    uint32_t freq_[N] = {};
+    uint16_t epoch_[N] = {};
 };
 
 // ---------------------------------------------------------------------------
 // Frequency function implementations
 // ---------------------------------------------------------------------------
 
-inline uint32_t gate_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
+template<typename Id>
+Id no_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx) {
+    return 0;
+}
+
+template<typename Id>
+Id first_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx) {
+    return inputs[0];
+}
+
+template<typename Id>
+Id gate_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx) {
+    auto& g = *static_cast<GateDesc const*>(desc);
+    return ctx.bit(g.addr) ? inputs[0] : 0;
+}
+
+template<typename Id>
+Id gate_inv_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx) {
+    auto& g = *static_cast<GateInvDesc const*>(desc);
+    return ctx.bit(g.addr) ? 0 : inputs[0];
+}
+
+template<typename Id>
+Id mux_input(void const* desc, Id const* inputs, EvalContext<Id> const& ctx) {
+    auto& m = *static_cast<MuxDesc const*>(desc);
+    uint32_t sel = ctx.field(m.field);
+    if (sel >= m.input_count) [[unlikely]]
+        return 0;
+    return inputs[sel];
+}
+
+template<typename Id>
+uint32_t gate_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
     auto& g = *static_cast<GateDesc const*>(desc);
-    return read_bit(g.addr.word_offset, g.addr.bit)
-        ? tree.getFrequency(inputs[0]) : 0;
+    return ctx.bit(g.addr)
+        ? in_freq : 0;
 }
 
-inline uint32_t gate_inv_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
+template<typename Id>
+uint32_t gate_inv_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
     auto& g = *static_cast<GateInvDesc const*>(desc);
-    return read_bit(g.addr.word_offset, g.addr.bit)
-        ? 0 : tree.getFrequency(inputs[0]);
+    return ctx.bit(g.addr)
+        ? 0 : in_freq;
 }
 
-inline uint32_t passthrough_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
-    return tree.getFrequency(inputs[0]);
+template<typename Id>
+uint32_t passthrough_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
+    return in_freq;
 }
 
-inline uint32_t gen_fixed_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
-    auto& g = *static_cast<GenFixedDesc const*>(desc);
-    if (g.polarity == Polarity::AlwaysOn) return g.frequency;
-    bool bit = read_bit(g.addr.word_offset, g.addr.bit);
+template<typename P, typename Ctx>
+constexpr typename P::type gen_fixed_freq(GenFixedDesc const& g, typename P::type in_freq, Ctx const& ctx) {
+    if (g.polarity == Polarity::AlwaysOn) return P::from(g.frequency);
+    bool bit = ctx.bit(g.addr);
     bool enabled = bit != (g.polarity == Polarity::ActiveLow);
-    return enabled ? g.frequency : 0;
+    return enabled ? P::from(g.frequency) : 0;
+}
+
+template<typename Id>
+uint32_t gen_fixed_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
+    return gen_fixed_freq(*static_cast<GenFixedDesc const*>(desc), in_freq, ctx);
 }
 
-inline uint32_t gen_external_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
-    auto& g = *static_cast<GenExternalDesc const*>(desc);
-    if (g.polarity == Polarity::AlwaysOn) return tree.state[g.state_slot];
-    bool bit = read_bit(g.addr.word_offset, g.addr.bit);
+template<typename P, typename Ctx>
+constexpr typename P::type gen_external_freq(GenExternalDesc const& g, typename P::type in_freq, Ctx const& ctx) {
+    if (g.polarity == Polarity::AlwaysOn) return P::from(ctx.tree.state[g.state_slot]);
+    bool bit = ctx.bit(g.addr);
     bool enabled = bit != (g.polarity == Polarity::ActiveLow);
-    return enabled ? tree.state[g.state_slot] : 0;
+    return enabled ? P::from(ctx.tree.state[g.state_slot]) : 0;
 }
 
-inline uint32_t table_div_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
-    auto& d = *static_cast<TableDivDesc const*>(desc);
-    uint32_t raw = read_field(d.field.word_offset, d.field.bit, d.field.width);
-    uint32_t divisor = raw < d.table_size ? tree.value_tables[d.table_offset + raw] : 0;
+template<typename Id>
+uint32_t gen_external_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
+    return gen_external_freq(*static_cast<GenExternalDesc const*>(desc), in_freq, ctx);
+}
+
+template<typename P, typename Ctx>
+constexpr typename P::type table_div_freq(TableDivDesc const& d, typename P::type in_freq, Ctx const& ctx) {
+    uint32_t raw = ctx.field(d.field);
+    uint32_t divisor = raw < d.table_size ? ctx.tree.value_tables[d.table_offset + raw] : 0;
     if (!divisor) return 0;
-    uint64_t in_freq = tree.getFrequency(inputs[0]);
-    return uint32_t(in_freq / divisor);
+    return P::div(in_freq, divisor);
+}
+
+template<typename Id>
+uint32_t table_div_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
+    return table_div_freq(*static_cast<TableDivDesc const*>(desc), in_freq, ctx);
 }
 
-inline uint32_t linear_div_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
-    auto& d = *static_cast<LinearDivDesc const*>(desc);
-    uint32_t raw = read_field(d.field.word_offset, d.field.bit, d.field.width);
+template<typename P, typename Ctx>
+constexpr typename P::type linear_div_freq(LinearDivDesc const& d, typename P::type in_freq, Ctx const& ctx) {
+    uint32_t raw = ctx.field(d.field);
     uint32_t divisor = raw + d.offset;
     if (!divisor) return 0;
-    uint64_t in_freq = tree.getFrequency(inputs[0]);
-    return uint32_t(in_freq / divisor);
+    return P::div(in_freq, divisor);
+}
+
+template<typename Id>
+uint32_t linear_div_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
+    return linear_div_freq(*static_cast<LinearDivDesc const*>(desc), in_freq, ctx);
 }
 
-inline uint32_t fixed_div_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
-    auto& d = *static_cast<FixedDivDesc const*>(desc);
+template<typename P, typename Ctx>
+constexpr typename P::type fixed_div_freq(FixedDivDesc const& d, typename P::type in_freq, Ctx const& ctx) {
     if (!d.divisor) return 0;
-    uint64_t in_freq = tree.getFrequency(inputs[0]);
-    return uint32_t(in_freq / d.divisor);
+    return P::div(in_freq, d.divisor);
 }
 
-inline uint32_t mux_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
-    auto& m = *static_cast<MuxDesc const*>(desc);
-    uint32_t sel = read_field(m.field.word_offset, m.field.bit, m.field.width);
-    if (sel >= m.input_count) [[unlikely]]
-        return 0;
-    return tree.getFrequency(inputs[sel]);
+template<typename Id>
+uint32_t fixed_div_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
+    return fixed_div_freq(*static_cast<FixedDivDesc const*>(desc), in_freq, ctx);
 }
 
-inline uint32_t pll_freq(void const* desc, uint8_t const* inputs, ClockTreeBase const& tree) {
-    auto& p = *static_cast<PllDesc const*>(desc);
-    uint32_t in_freq = tree.getFrequency(inputs[0]);
+template<typename P, typename Ctx>
+constexpr typename P::type frac_div_freq(FracDivDesc const& d, typename P::type in_freq, Ctx const& ctx) {
+    uint32_t factor = ctx.field(d.factor);
+    if (d.frac_bits) {
+        // output = input * 2^frac_bits / (INT << frac_bits + FRAC); INT = 0
+        // stands for 2^16, the largest integer divisor
+        if (!factor) factor = uint32_t(1) << 16;
+        uint64_t divisor = (uint64_t(factor) << d.frac_bits) + ctx.field(d.denominator);
+        return P::scale(in_freq, uint64_t(1) << d.frac_bits, divisor);
+    }
+    // output = input * D / (base * D + N)
+    uint64_t den = ctx.field(d.denominator) + d.offset;
+    uint64_t divisor = d.base * den + factor;
+    if (!den || !divisor) return 0;
+    return P::scale(in_freq, den, divisor);
+}
+
+template<typename Id>
+uint32_t frac_div_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
+    return frac_div_freq(*static_cast<FracDivDesc const*>(desc), in_freq, ctx);
+}
+
+template<typename P, typename Ctx>
+constexpr typename P::type pll_freq(PllDesc const& p, typename P::type in_freq, Ctx const& ctx) {
     if (!in_freq) return 0;
 
-    uint64_t fb_int = read_field(p.fb_int.word_offset, p.fb_int.bit, p.fb_int.width) + p.fb_int_offset;
+    uint64_t fb_int = ctx.field(p.fb_int) + p.fb_int_offset;
     uint64_t fb_frac = p.fb_frac.width
-        ? read_field(p.fb_frac.word_offset, p.fb_frac.bit, p.fb_frac.width) : 0;
+        ? ctx.field(p.fb_frac) : 0;
 
     // output = input * (fb_int + fb_frac / 2^frac_bits) / post_div
     //        = input * (fb_int << frac_bits + fb_frac) / (post_div << frac_bits)
     uint64_t numerator = (fb_int << p.frac_bits) + fb_frac;
 
     uint64_t post_div = p.post_div.width
-        ? read_field(p.post_div.word_offset, p.post_div.bit, p.post_div.width) + p.post_div_offset : 1;
+        ? ctx.field(p.post_div) + p.post_div_offset : 1;
     if (!post_div) return 0;
 
     uint64_t denominator = post_div << p.frac_bits;
-    return uint32_t(uint64_t(in_freq) * numerator / denominator);
+    return P::scale(in_freq, numerator, denominator);
+}
+
+template<typename Id>
+uint32_t pll_freq(void const* desc, uint32_t in_freq, EvalContext<Id> const& ctx) {
+    return pll_freq(*static_cast<PllDesc const*>(desc), in_freq, ctx);
+}
+
+// ---------------------------------------------------------------------------
+// PLL solver implementation
+// ---------------------------------------------------------------------------
+
+/*
+ * The search runs over the reference and post-divider factors only, pruned
+ * up front to those that keep the reference frequency and the VCO (at the
+ * target output) within their limits. For each pair the feedback factor,
+ * in units of 2^-frac_bits, follows directly by rounding
+ * target * post_div * ref_div / in_freq. The smallest error wins; among equal
+ * errors the smallest reference and post-dividers, which keep the PLL's
+ * comparison frequency high and its VCO low. An exact match ends the search.
+ */
+template<typename Id>
+constexpr PllSettings solve_pll(PllPath<Id> const& p, uint32_t in_freq, uint32_t target) {
+    PllSettings best{};
+    if (!in_freq || !target)
+        return best;
+
+    uint32_t fb = p.pll.frac_bits;
+    uint64_t n_min = (uint64_t(p.fb_int_range.min) << fb) + p.fb_frac_range.min;
+    uint64_t n_max = (uint64_t(p.fb_int_range.max) << fb) + p.fb_frac_range.max;
+
+    uint32_t m_lo = p.ref_div_range.min, m_hi = p.ref_div_range.max;
+    if (p.ref_freq.max && m_lo < (in_freq - 1) / p.ref_freq.max + 1)
+        m_lo = (in_freq - 1) / p.ref_freq.max + 1;
+    if (p.ref_freq.min && m_hi > in_freq / p.ref_freq.min)
+        m_hi = in_freq / p.ref_freq.min;
+    uint32_t d_lo = p.post_div_range.min, d_hi = p.post_div_range.max;
+    if (p.vco_freq.min && d_lo < (p.vco_freq.min - 1) / target + 1)
+        d_lo = (p.vco_freq.min - 1) / target + 1;
+    if (d_hi > p.vco_freq.max / target)
+        d_hi = p.vco_freq.max / target;
+
+    uint32_t best_err = 0xFFFFFFFF;
+    for (uint32_t m = m_lo; m <= m_hi; ++m) {
+        for (uint32_t d = d_lo; d <= d_hi; ++d) {
+            // n = target * d * m / in_freq in units of 2^-fb, rounded
+            uint64_t num = uint64_t(target) * d * m;
+            uint64_t n_int = num / in_freq;
+            if (n_int > p.fb_int_range.max)
+                break;          // Grows with d
+            uint64_t n = (n_int << fb) + (((num % in_freq) << fb) + in_freq / 2) / in_freq;
+            if (n < n_min) n = n_min;
+            if (n > n_max) n = n_max;
+            uint64_t frac = n & ((uint64_t(1) << fb) - 1);
+            if (frac < p.fb_frac_range.min) frac = p.fb_frac_range.min;
+            if (frac > p.fb_frac_range.max) frac = p.fb_frac_range.max;
+            n = (n >> fb << fb) + frac;
+
+            uint64_t vco = uint64_t(in_freq) * n / (uint64_t(m) << fb);
+            uint64_t out = vco / d;
+            if (vco < p.vco_freq.min || vco > p.vco_freq.max
+                    || out < p.out_freq.min || out > p.out_freq.max)
+                continue;
+            uint32_t err = uint32_t(out > target ? out - target : target - out);
+            if (err < best_err) {
+                best_err = err;
+                best = {m - p.ref_div.offset, uint32_t(n >> fb) - p.pll.fb_int_offset, uint32_t(frac),
+                        d - p.pll.post_div_offset, uint32_t(out)};
+                if (!err)
+                    return best;
+            }
+        }
+    }
+    return best;
 }
 
 } // namespace clocktree
@@ -0,0 +1,37 @@
+# Clock-tree footprint aggregator — merges the per-tree size reports written
+# by generate_clocktree_header.py into one report.
+#
+# Usage: python3 clocktree_footprint.py <output.json> <tree.footprint.json>...
+#
+# The output lists every tree's report, ordered by namespace and tree name,
+# and the ROM/RAM totals over all trees and per element type.  A summary
+# table is printed to stdout.
+
+import json
+import sys
+from pathlib import Path
+
+trees = sorted((json.loads(Path(p).read_text()) for p in sys.argv[2:]),
+               key=lambda t: (t['namespace'], t['tree']))
+
+element_types = {}
+for t in trees:
+    for key, e in t['element_types'].items():
+        total = element_types.setdefault(key, {'count': 0, 'bytes': 0})
+        total['count'] += e['count']
+        total['bytes'] += e['bytes']
+
+report = {
+    'trees': trees,
+    'rom_total': sum(t['rom_total'] for t in trees),
+    'ram_total': sum(t['ram']['state_data'] for t in trees),
+    'element_types': dict(sorted(element_types.items(), key=lambda e: -e[1]['bytes'])),
+}
+Path(sys.argv[1]).write_text(json.dumps(report, indent=2) + '\n')
+
+print(f"{'tree':<32} {'signals':>7} {'descriptors':>11} {'signal_table':>12} {'rom':>7} {'ram':>5}")
+for t in trees:
+    name = f"{t['namespace']}::{t['tree']}"
+    print(f"{name:<32} {t['signals']:>7} {t['rom']['descriptors']:>11} {t['rom']['signal_table']:>12} "
+          f"{t['rom_total']:>7} {t['ram']['state_data']:>5}")
+print(f"{'total':<32} {'':>7} {'':>11} {'':>12} {report['rom_total']:>7} {report['ram_total']:>5}")
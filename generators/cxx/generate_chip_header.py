@@ -20,6 +20,8 @@ class ChipFormatter:
 /** Integration parameters for $name */
 EXPORT constexpr struct $ns::${model}::Intgr i_$name = {$params$ints$init};
 """))
+        self.aliasesTemplate      = Template(keywords.get('aliases', ',\n\t.aliases = {.toggle = ${xor}u, .set = ${set}u, .clear = ${clear}u}'))
+        self.bitBandTemplate      = Template(keywords.get('bitBand', ',\n\t.bitBand = true'))
         # Block-name → (param_names, interrupt_names) cache, populated lazily.
         # The block model is the authoritative source for designated-initializer
         # order; chip-side lists are sorted to match before emission.
@@ -147,7 +149,8 @@ EXPORT constexpr struct $ns::${model}::Intgr i_$name = {$params$ints$init};
                 chip_dir, models_map, m)
             params = self.createParameters(k, i, param_order, param_defaults)
             ints = self.createInterrupts(k, i, int_order)
-            init = '\n\t.registers = %#Xu\n' % i['baseAddress']
+            init = '\n\t.registers = %#Xu' % i['baseAddress']
+            init += self.createAliases(chip, k) + self.createBitBand(chip, i) + '\n'
             decl += self.instanceDeclTemplate.substitute(i, name=k, ns=ns, params=params, ints=ints, init=init)
         includes = [
             self.instanceInclTemplate.substitute(model=m, ns=ns, incl_suffix=sys.argv[4])
@@ -155,6 +158,29 @@ EXPORT constexpr struct $ns::${model}::Intgr i_$name = {$params$ints$init};
         ]
         return decl, ''.join(includes), model_to_ns
 
+    def createAliases(self, chip, instance_name):
+        """ initialize the atomic access aliases of an instance that has them.
+
+        Every instance of a chip with `atomicAliases` has them, except those
+        in its `exclude` list.
+        """
+        aliases = chip.get('atomicAliases')
+        if not aliases or instance_name in aliases.get('exclude', []):
+            return ''
+        return self.aliasesTemplate.substitute({k: '%#x' % aliases[k] for k in ('xor', 'set', 'clear')})
+
+    def createBitBand(self, chip, instance):
+        """ mark an instance that has a bit-band alias.
+
+        Only Cortex-M3 and M4 cores have one, for the first MB of the
+        peripheral region.
+        """
+        if chip.get('cpu', {}).get('name') not in ('CM3', 'CM4'):
+            return ''
+        if instance['baseAddress'] & 0xFFF00000 != 0x40000000:
+            return ''
+        return self.bitBandTemplate.substitute()
+
     def createHeader(self, chip, chip_path, namespaces, prefix, postfix):
         namespace = namespaces
         inverse = {}
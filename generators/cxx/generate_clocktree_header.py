@@ -8,6 +8,7 @@ Usage: called from generate_header.py when the model has a 'signals' key.
 """
 
 from ruamel.yaml import YAML
+import json
 from pathlib import Path
 import sys
 
@@ -18,6 +19,7 @@ import sys
 
 _periph_cache = {}   # instance_name -> { 'base': int, 'regs': {reg_name: {offset, fields: {name: {bitOffset, bitWidth}}}} }
 _chip_cache = {}     # resolved model_dir -> chip dict (or None)
+register_base = 0x40000000  # base of BitAddr/FieldAddr word offsets, see choose_register_base()
 
 def find_model_file(name, start_dir):
     """Find a YAML model file by name, searching start_dir and ancestors."""
@@ -154,35 +156,40 @@ def load_chip_model(model_dir, devices=None):
     """Find and load the chip model to get peripheral base addresses.
     The chip model has 'instances' key with baseAddress per peripheral.
 
-    When `devices` is non-empty, only return a chip yaml whose `name` is
-    in that list — required when model_dir's subtree contains multiple
-    chip yamls (e.g. models/Raspberry/RP/ with both RP2040 and RP2350)
-    and the caller knows which one the clocktree is associated with."""
+    When `devices` is non-empty, only return a chip yaml of one of those
+    devices — required when model_dir's subtree contains multiple chip
+    yamls (e.g. models/Raspberry/RP/ with both RP2040 and RP2350) and the
+    caller knows which one the clocktree is associated with.  A chip is of
+    a device when its `name` is the device (RP2040), names a core of it
+    (STM32H757_CM7), or the chip yaml lives in a directory named after it
+    (SAME70/SAME70/ATSAME70Q21B.yaml)."""
     devices_set = set(devices) if devices else None
 
-    def matches(data):
+    def matches(f, data):
         if devices_set is None:
             return True
-        return data.get('name') in devices_set
+        name = str(data.get('name', ''))
+        return (name in devices_set or name.split('_')[0] in devices_set
+                or any(part in devices_set for part in f.parent.parts))
 
     # Search for a YAML file with 'instances' key in model_dir and ancestors
     d = Path(model_dir)
     while d != d.parent:
-        for f in d.glob("*.yaml"):
+        for f in sorted(d.glob("*.yaml")):
             try:
                 yaml = YAML(typ='safe')
                 data = yaml.load(f)
-                if data and 'instances' in data and matches(data):
+                if data and 'instances' in data and matches(f, data):
                     return data
             except:
                 continue
         d = d.parent
     # Fallback: chip model may live in a subdirectory (e.g. LPC43xx/LPC4330.yaml).
-    for f in Path(model_dir).rglob("*.yaml"):
+    for f in sorted(Path(model_dir).rglob("*.yaml")):
         try:
             yaml = YAML(typ='safe')
             data = yaml.load(f)
-            if data and 'instances' in data and matches(data):
+            if data and 'instances' in data and matches(f, data):
                 return data
         except:
             continue
@@ -190,8 +197,9 @@ def load_chip_model(model_dir, devices=None):
 
 
 def resolve_base_addresses(model_dir):
-    """Load chip model and populate base addresses in peripheral cache."""
-    chip = load_chip_model(model_dir)
+    """Populate base addresses in peripheral cache from the chip model that
+    generate_header() selected by the clock tree's `devices`."""
+    chip = _load_chip_cached(model_dir)
     if not chip:
         return
     instances = chip.get('instances', {})
@@ -213,16 +221,36 @@ def get_bit_addr(instance, reg_name, field_name, model_dir):
     if base is None:
         raise ValueError(f"Base address not found for {instance}")
     byte_addr = base + reg['addressOffset']
-    # Word offset relative to Cortex-M peripheral base 0x40000000
-    word_offset = (byte_addr - 0x40000000) >> 2
+    # Word offset relative to the clock tree's register_base
+    word_offset = (byte_addr - register_base) >> 2
+    if not 0 <= word_offset < (1 << 27):
+        raise ValueError(f"{instance}.{reg_name} at {byte_addr:#x} is outside the "
+                         f"512 MB window at register base {register_base:#x}")
     return word_offset, field['bitOffset'], field['bitWidth']
 
 
+def choose_register_base(instances):
+    """Pick the base address that BitAddr/FieldAddr word offsets are relative
+    to: the lowest base address of the given peripheral instances, rounded
+    down to 1 MB.  Defaults to the Cortex-M peripheral region 0x40000000.
+    """
+    bases = [_periph_cache[i]['base'] for i in instances
+             if i in _periph_cache and _periph_cache[i].get('base') is not None]
+    if not bases:
+        return 0x40000000
+    return min(bases) & ~0xFFFFF
+
+
 # ---------------------------------------------------------------------------
 # Signal/element tracking
 # ---------------------------------------------------------------------------
 
 elements = {}  # signal_name -> (elem_name, elem_type, elem_obj)
+element_inputs = {}  # signal_name -> list of input signal IDs
+element_fields = {}  # signal_name -> {word_offset: bit mask} of the register fields read by the element
+_pending_fields = []  # (word_offset, mask) of the fields referenced by the element being built
+linear_divs = {}  # signal_name -> (input_name, field_addr, offset, factor range) of a linear divider
+pll_fields = {}  # signal_name -> (input_name, PLL field parts, post-divider range, vco_limits, solvable)
 signal_enum_map = {}
 signal_index = {}  # signal_name -> integer index
 
@@ -255,7 +283,7 @@ def intern_value_table(values):
 # Input pool — flat array of signal IDs for element inputs
 # ---------------------------------------------------------------------------
 
-input_pool = []  # flat list of uint8_t signal IDs
+input_pool = []  # flat list of signal IDs
 
 
 def add_inputs(*signal_names):
@@ -288,12 +316,14 @@ def get_state_slot(name, default=0):
 def make_bit_addr(instance, reg, field, model_dir):
     """Format a BitAddr initializer."""
     w, b, _ = get_bit_addr(instance, reg, field, model_dir)
+    _pending_fields.append((w, 1 << b))
     return f"{{{w}, {b}}}"
 
 
 def make_field_addr(instance, reg, field, model_dir):
     """Format a FieldAddr initializer and return (string, width)."""
     w, b, width = get_bit_addr(instance, reg, field, model_dir)
+    _pending_fields.append((w, ((1 << width) - 1) << b))
     return f"{{{w}, {b}, {width}}}", width
 
 
@@ -398,6 +428,21 @@ def build_divider(div, instance, model_dir):
     field = factor['field']
     values = factor.get('values')
     value_range = factor.get('value_range')
+    denominator = div.get('denominator')
+
+    if denominator:
+        # Fractional divider. A denominator field in the factor's register
+        # holds the fraction below the integer factor (INT + FRAC / 2^width,
+        # e.g. RP2040, where INT = 0 divides by 2^16); one in a register of
+        # its own divides the factor, and
+        # the fixed value is added to the ratio (e.g. LPC8 FRG).
+        fa, width = make_field_addr(inst, reg, field, model_dir)
+        den_inst = denominator.get('instance', instance)
+        da, den_width = make_field_addr(den_inst, denominator['reg'], denominator['field'], model_dir)
+        if (den_inst, denominator['reg']) == (inst, reg):
+            return ('frac_div', f'{{{fa}, {da}, 0, {den_width}, 0}}', input_offset)
+        den_offset = (denominator.get('value_range') or {}).get('offset', 0)
+        return ('frac_div', f'{{{fa}, {da}, {den_offset}, 0, {fixed_value or 0}}}', input_offset)
 
     if values:
         # Table-based divider
@@ -408,10 +453,12 @@ def build_divider(div, instance, model_dir):
         # Linear divider: divisor = raw + offset
         offset = value_range.get('offset', 0)
         fa, width = make_field_addr(inst, reg, field, model_dir)
+        linear_divs[div['output']] = (inp, fa, offset, factor_range(value_range, width, offset))
         return ('linear_div', f'{{{fa}, {offset}}}', input_offset)
     else:
         # Raw field value as divisor (offset=0)
         fa, width = make_field_addr(inst, reg, field, model_dir)
+        linear_divs[div['output']] = (inp, fa, 0, factor_range(None, width, 0))
         return ('linear_div', f'{{{fa}, 0}}', input_offset)
 
 
@@ -435,17 +482,17 @@ def build_pll(pll, instance, model_dir):
 
     def make_pll_field(field_data, default_offset=0):
         if field_data is None:
-            return '{0, 0, 0}', 0, default_offset
+            return '{0, 0, 0}', 0, default_offset, (default_offset, default_offset)
         inst = field_data.get('instance', instance)
         fa_str, width = make_field_addr(inst, field_data['reg'], field_data['field'], model_dir)
         vr = field_data.get('value_range')
         offset = vr.get('offset', 0) if vr else default_offset
         frac_max = vr.get('max', 0) if vr else 0
-        return fa_str, frac_max, offset
+        return fa_str, frac_max, offset, factor_range(vr, width, offset)
 
-    fb_int_str, _, fb_int_offset = make_pll_field(pll.get('feedback_integer'), 1)
-    fb_frac_str, frac_max, _ = make_pll_field(pll.get('feedback_fraction'), 0)
-    post_div_str, _, post_div_offset = make_pll_field(pll.get('post_divider'), 1)
+    fb_int_str, _, fb_int_offset, fb_int_range = make_pll_field(pll.get('feedback_integer'), 1)
+    fb_frac_str, frac_max, _, fb_frac_range = make_pll_field(pll.get('feedback_fraction'), 0)
+    post_div_str, _, post_div_offset, post_div_range = make_pll_field(pll.get('post_divider'), 1)
 
     # Determine fractional bits from max value
     frac_bits = 0
@@ -454,22 +501,39 @@ def build_pll(pll, instance, model_dir):
         if frac_max_val > 0:
             frac_bits = frac_max_val.bit_length()
 
+    # The solver handles linear feedback factors only, not table-encoded ones
+    solvable = 'values' not in (pll.get('feedback_integer') or {})
+    pll_fields[pll['output']] = (
+        inp,
+        (fb_int_str, fb_int_offset, fb_frac_str, frac_bits, post_div_str, post_div_offset),
+        (fb_int_range, fb_frac_range, post_div_range if pll.get('post_divider') else None),
+        pll.get('vco_limits'),
+        solvable)
+
     return ('pll', f'{{{fb_int_str}, {fb_int_offset}, {fb_frac_str}, {frac_bits}, {post_div_str}, {post_div_offset}}}', input_offset)
 
 
+def factor_range(value_range, width, offset):
+    """Return (min, max) of the factor, i.e. the raw field value plus offset,
+    from the field's value_range or else from its width."""
+    lo = value_range.get('min', 0) if value_range else 0
+    hi = value_range.get('max', (1 << width) - 1) if value_range else (1 << width) - 1
+    return lo + offset, hi + offset
+
+
 # ---------------------------------------------------------------------------
 # Code generation
 # ---------------------------------------------------------------------------
 
-# Type registry: type_key -> (cpp_desc_type, cpp_freq_fn, list_of_descriptors)
+# Type registry: type_key -> (cpp_desc_type, (cpp_input_fn, cpp_freq_fn, kind), list_of_descriptors)
 type_registry = {}
 # signal_entries: list of (type_key, desc_index, input_offset) indexed by signal index
 signal_entries = []
 
 
-def register_type(key, cpp_type, cpp_fn):
+def register_type(key, cpp_type, kind, cpp_input_fn, cpp_freq_fn):
     if key not in type_registry:
-        type_registry[key] = (cpp_type, cpp_fn, [])
+        type_registry[key] = (cpp_type, (cpp_input_fn, cpp_freq_fn, kind), [])
 
 
 def add_element(output_signal, type_key, desc_str, input_offset):
@@ -478,23 +542,223 @@ def add_element(output_signal, type_key, desc_str, input_offset):
     desc_index = len(descs)
     descs.append(desc_str)
     elements[output_signal] = (type_key, desc_index, input_offset)
+    # The builder has just appended this element's inputs to the pool.
+    element_inputs[output_signal] = input_pool[input_offset:]
+    fields = {}
+    for w, mask in _pending_fields:
+        fields[w] = fields.get(w, 0) | mask
+    element_fields[output_signal] = fields
+    _pending_fields.clear()
+
+
+def topological_order(signals):
+    """Return all signal indices ordered so that every element's inputs come
+    before its output.  Ties are broken by signal index, which keeps the
+    order stable and close to the YAML order.  Raises ValueError if the
+    clock tree contains a cycle.
+    """
+    import heapq
+    count = len(signals)
+    pending = [0] * count       # number of not-yet-ordered inputs
+    fanout = [[] for _ in range(count)]
+    for i, s in enumerate(signals):
+        for src in set(element_inputs.get(s['name'], [])):
+            if src != 0:
+                pending[i] += 1
+                fanout[src].append(i)
+    ready = [i for i in range(count) if pending[i] == 0]
+    heapq.heapify(ready)
+    order = []
+    while ready:
+        i = heapq.heappop(ready)
+        order.append(i)
+        for dst in fanout[i]:
+            pending[dst] -= 1
+            if pending[dst] == 0:
+                heapq.heappush(ready, dst)
+    if len(order) != count:
+        stuck = [signals[i]['name'] for i in range(count) if pending[i]]
+        raise ValueError(f"Clock tree contains a cycle through: {', '.join(stuck)}")
+    return order
+
+
+def max_depth(signals, order):
+    """Return the length of the longest chain of elements in the tree, i.e.
+    the most signals the evaluator passes from any signal to its source.
+    At least 1, so the evaluator's path array is never zero-sized.
+    """
+    depth = [0] * len(signals)
+    for i in order:
+        name = signals[i]['name']
+        if name in elements:
+            depth[i] = 1 + max((depth[src] for src in element_inputs[name]), default=0)
+    return max(1, max(depth))
+
+
+def snapshot_sizes(signals, order):
+    """Return (snapshot_words, register_words): the largest number of
+    distinct register words read while evaluating any single signal, and the
+    number of distinct register words in the whole tree.  Both are at least 1
+    so the snapshot buffers are never zero-sized.
+    """
+    closure = [set() for _ in signals]
+    for i in order:
+        name = signals[i]['name']
+        words = set(element_fields.get(name, {}))
+        for src in element_inputs.get(name, []):
+            words |= closure[src]
+        closure[i] = words
+    all_words = set().union(*element_fields.values()) if element_fields else set()
+    return max(1, max(len(c) for c in closure)), max(1, len(all_words))
+
+
+def fanout_table(signals):
+    """Return (offsets, pool): the dependents of signal i, i.e. the signals
+    driven by an element that has i as an input, are pool[offsets[i]:offsets[i+1]].
+    """
+    fanout = [[] for _ in signals]
+    for i, s in enumerate(signals):
+        for src in sorted(set(element_inputs.get(s['name'], []))):
+            if src != 0:
+                fanout[src].append(i)
+    offsets, pool = [0], []
+    for deps in fanout:
+        pool.extend(deps)
+        offsets.append(len(pool))
+    return offsets, pool
+
+
+def field_uses(signals):
+    """Return (word_offset, mask, signal index) for every register word read
+    by an element, sorted by word offset."""
+    uses = []
+    for i, s in enumerate(signals):
+        for w, mask in element_fields.get(s['name'], {}).items():
+            uses.append((w, mask, i))
+    return sorted(uses)
+
+
+def pll_paths(signals):
+    """Return the PLL solver paths as (input, output, ref_div, pll, ranges, limits).
+
+    A path runs from the input of the PLL's reference divider (a linear divider
+    driving the PLL input, if any) through the PLL to one of its outputs: the
+    PLL output itself, with the PLL's own post-divider if it has one, or else
+    each linear divider fed by the PLL output.
+    """
+    unlimited = (0, 0xFFFFFFFF)
+
+    def limits(name):
+        s = signals[signal_index[name]]
+        return s.get('min', 0), s.get('max', 0xFFFFFFFF)
+
+    paths = []
+    for out, (inp, parts, (int_range, frac_range, post_range), vco_limits, solvable) in pll_fields.items():
+        if not solvable:
+            continue
+        if inp in linear_divs:
+            src, ref_fa, ref_offset, ref_range = linear_divs[inp]
+        else:
+            src, ref_fa, ref_offset, ref_range = inp, '{0, 0, 0}', 1, (1, 1)
+        ref_range = (max(ref_range[0], 1), ref_range[1])
+        fb_int, fb_int_offset, fb_frac, frac_bits, post_div, post_div_offset = parts
+        if not frac_bits:
+            frac_range = (0, 0)
+        if vco_limits:
+            vco = (vco_limits.get('min', 0), vco_limits.get('max', 0xFFFFFFFF))
+        else:
+            vco = limits(out) if post_range is None else unlimited
+
+        stages = []
+        if post_range is not None:
+            stages.append((out, post_div, post_div_offset, post_range))
+        else:
+            stages.append((out, '{0, 0, 0}', 1, (1, 1)))
+            for name, (div_in, fa, offset, div_range) in linear_divs.items():
+                if div_in == out:
+                    stages.append((name, fa, offset, div_range))
+        for name, fa, offset, div_range in stages:
+            div_range = (max(div_range[0], 1), div_range[1])
+            if ref_range[0] > ref_range[1] or div_range[0] > div_range[1]:
+                continue
+            pll = f'{{{fb_int}, {fb_int_offset}, {fb_frac}, {frac_bits}, {fa}, {offset}}}'
+            paths.append((signal_index[src], signal_index[name], f'{{{ref_fa}, {ref_offset}}}', pll,
+                          (ref_range, int_range, frac_range, div_range),
+                          (limits(inp), vco, limits(name)), name))
+    return paths
+
+
+# Sizes of the clocktree.hpp structs on a 32-bit target (4-byte pointers,
+# 4-byte aligned uint32_t).  The descriptors don't depend on the Id width.
+target_sizeof = {
+    'clocktree::GateDesc': 4,
+    'clocktree::GateInvDesc': 4,
+    'uint8_t': 1,
+    'clocktree::GenFixedDesc': 12,
+    'clocktree::GenExternalDesc': 8,
+    'clocktree::TableDivDesc': 12,
+    'clocktree::LinearDivDesc': 12,
+    'clocktree::FixedDivDesc': 2,
+    'clocktree::FracDivDesc': 20,
+    'clocktree::MuxDesc': 12,
+    'clocktree::PllDesc': 36,
+    'clocktree::BlockType': 16,
+    'clocktree::FieldUse': 12,
+    'clocktree::Limits': 12,
+    'clocktree::PllPath': 108,
+}
+
+
+def footprint(name, namespace, id_size, tables, active_types, signal_count, state_count):
+    """Return the size report of a generated tree: the bytes of each constant
+    table, the descriptor bytes per element type, and the RAM taken by the
+    tree's state and by a CachedClockTree's frequency cache.
+
+    `tables` maps table names to (entry count, entry size).  Passthrough
+    elements have no descriptors and share one dummy byte.
+    """
+    types = {}
+    for key in active_types:
+        cpp_type, _, descs = type_registry[key]
+        size = target_sizeof[cpp_type]
+        types[key] = {'count': len(descs), 'desc_size': size,
+                      'bytes': size if cpp_type == 'uint8_t' else size * len(descs)}
+    rom = {'descriptors': sum(t['bytes'] for t in types.values())}
+    rom.update((table, count * size) for table, (count, size) in tables.items())
+    ram = {'state_data': 4 * max(state_count, 1),
+           'frequency_cache': 6 * signal_count}
+    return {
+        'tree': name,
+        'namespace': namespace,
+        'pointer_size': 4,
+        'signals': signal_count,
+        'id_size': id_size,
+        'rom': rom,
+        'rom_total': sum(rom.values()),
+        'ram': ram,
+        'element_types': dict(sorted(types.items(), key=lambda t: -t[1]['bytes'])),
+    }
 
 
 # Register all standard types
 def init_types():
-    register_type('gate',         'clocktree::GateDesc',        'clocktree::gate_freq')
-    register_type('gate_inv',     'clocktree::GateInvDesc',     'clocktree::gate_inv_freq')
-    register_type('passthrough',  'uint8_t',                    'clocktree::passthrough_freq')
-    register_type('gen_fixed',    'clocktree::GenFixedDesc',    'clocktree::gen_fixed_freq')
-    register_type('gen_external', 'clocktree::GenExternalDesc', 'clocktree::gen_external_freq')
-    register_type('table_div',    'clocktree::TableDivDesc',    'clocktree::table_div_freq')
-    register_type('linear_div',   'clocktree::LinearDivDesc',   'clocktree::linear_div_freq')
-    register_type('fixed_div',    'clocktree::FixedDivDesc',    'clocktree::fixed_div_freq')
-    register_type('mux',          'clocktree::MuxDesc',         'clocktree::mux_freq')
-    register_type('pll',          'clocktree::PllDesc',         'clocktree::pll_freq')
-
-
-def generate_header(yaml_path, namespace, hpp_path, module_name=None):
+    register_type('gate',         'clocktree::GateDesc',        'clocktree::Kind::Gate',        'clocktree::gate_input',     'clocktree::gate_freq')
+    register_type('gate_inv',     'clocktree::GateInvDesc',     'clocktree::Kind::GateInv',     'clocktree::gate_inv_input', 'clocktree::gate_inv_freq')
+    register_type('passthrough',  'uint8_t',                    'clocktree::Kind::Passthrough', 'clocktree::first_input',    'clocktree::passthrough_freq')
+    register_type('gen_fixed',    'clocktree::GenFixedDesc',    'clocktree::Kind::GenFixed',    'clocktree::no_input',       'clocktree::gen_fixed_freq')
+    register_type('gen_external', 'clocktree::GenExternalDesc', 'clocktree::Kind::GenExternal', 'clocktree::no_input',       'clocktree::gen_external_freq')
+    register_type('table_div',    'clocktree::TableDivDesc',    'clocktree::Kind::TableDiv',    'clocktree::first_input',    'clocktree::table_div_freq')
+    register_type('linear_div',   'clocktree::LinearDivDesc',   'clocktree::Kind::LinearDiv',   'clocktree::first_input',    'clocktree::linear_div_freq')
+    register_type('fixed_div',    'clocktree::FixedDivDesc',    'clocktree::Kind::FixedDiv',    'clocktree::first_input',    'clocktree::fixed_div_freq')
+    register_type('frac_div',     'clocktree::FracDivDesc',     'clocktree::Kind::FracDiv',     'clocktree::first_input',    'clocktree::frac_div_freq')
+    register_type('mux',          'clocktree::MuxDesc',         'clocktree::Kind::Mux',         'clocktree::mux_input',      'clocktree::passthrough_freq')
+    register_type('pll',          'clocktree::PllDesc',         'clocktree::Kind::Pll',         'clocktree::first_input',    'clocktree::pll_freq')
+
+
+def generate_header(yaml_path, namespace, hpp_path, module_name=None, id_type=None):
+    """Write the clock-tree header for a model. `id_type` forces the signal
+    ID type ('uint8_t' or 'uint16_t') instead of the narrowest that fits,
+    so that the wide tables can be tested on a small tree."""
     # Reset module-level caches so successive generate_header calls in the
     # same process don't reuse a chip/peripheral resolved against a different
     # clocktree's context.
@@ -540,6 +804,8 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
         if inst:
             load_peripheral_model(inst, model_dir)
     resolve_base_addresses(model_dir)
+    global register_base
+    register_base = choose_register_base(instances_used)
 
     # Initialize type registry
     init_types()
@@ -570,7 +836,7 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
     type_index = {}  # type_key -> 1-based index
     active_types = []
     idx = 1
-    for key, (cpp_type, cpp_fn, descs) in type_registry.items():
+    for key, (cpp_type, cpp_fns, descs) in type_registry.items():
         if descs:
             type_index[key] = idx
             active_types.append(key)
@@ -588,7 +854,14 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
             signal_lines.append(f'        {{0, 0, 0}},  // {name}')
 
     # --- Format Signals enum ---
+    # Signal IDs, descriptor indices and the input pool share one width
     sig_typ = 'uint8_t' if len(signals) <= 256 else 'uint16_t'
+    if id_type:
+        if id_type not in ('uint8_t', 'uint16_t'):
+            raise ValueError(f"Unsupported signal ID type {id_type}")
+        if id_type == 'uint8_t' and sig_typ != id_type:
+            raise ValueError(f"{len(signals)} signals don't fit signal IDs of type {id_type}")
+        sig_typ = id_type
     enum_lines = []
     for s in signals:
         name = signal_enum_map[s['name']]
@@ -598,7 +871,7 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
     desc_array_lines = []
     desc_array_names = {}
     for key in active_types:
-        cpp_type, cpp_fn, descs = type_registry[key]
+        cpp_type, cpp_fns, descs = type_registry[key]
         arr_name = f'{key}_descs'
         desc_array_names[key] = arr_name
         if cpp_type == 'uint8_t':
@@ -611,15 +884,45 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
             desc_array_lines.append('    };')
 
     # --- Format type table ---
-    type_table_lines = ['    static constexpr clocktree::BlockType type_table[] = {']
+    type_table_lines = ['    static constexpr clocktree::BlockType<Id> type_table[] = {']
     type_table_lines.append('        {},  // index 0 = undriven')
     for key in active_types:
-        cpp_type, cpp_fn, descs = type_registry[key]
+        cpp_type, (cpp_input_fn, cpp_freq_fn, kind), descs = type_registry[key]
         arr_name = desc_array_names[key]
         desc_size = f'sizeof({cpp_type})' if cpp_type != 'uint8_t' else '1'
-        type_table_lines.append(f'        {{{cpp_fn}, {arr_name}, {desc_size}}},  // {key}')
+        type_table_lines.append(f'        {{{cpp_input_fn}<Id>, {cpp_freq_fn}<Id>, {arr_name}, {desc_size}, {kind}}},  // {key}')
     type_table_lines.append('    };')
 
+    # --- Topological order for single-pass evaluation ---
+    topo_order = topological_order(signals)
+    topo_order_str = ', '.join(str(i) for i in topo_order)
+
+    # --- Register snapshot sizes ---
+    snapshot_words, register_words = snapshot_sizes(signals, topo_order)
+
+    # --- Evaluator path length ---
+    depth = max_depth(signals, topo_order)
+
+    # --- Reverse dependencies ---
+    fanout_offsets, fanout_pool = fanout_table(signals)
+    fanout_offsets_str = ', '.join(str(v) for v in fanout_offsets)
+    fanout_pool_str = ', '.join(str(v) for v in fanout_pool) or '0'
+    field_use_lines = [f'        {{{w}, {mask:#010x}, {i}}},  // {signals[i]["name"]}'
+                       for w, mask, i in field_uses(signals)] or ['        {0, 0, 0},']
+
+    # --- PLL solver paths ---
+    pll_path_lines = []
+    for src, dst, ref_div, pll, ranges, lims, name in pll_paths(signals):
+        rng = ', '.join(f'{{{lo}, {"0xFFFFFFFF" if hi == 0xFFFFFFFF else hi}}}' for lo, hi in ranges + lims)
+        pll_path_lines.append(f'        {{{src}, {dst}, {ref_div}, {pll}, {rng}}},  // {name}')
+
+    # --- Signal frequency limits ---
+    limit_lines = []
+    for sig in signals:
+        lo, hi = sig.get('min', 0), sig.get('max', 0xFFFFFFFF)
+        limit_lines.append(f'        {{{{{lo}, {"0xFFFFFFFF" if hi == 0xFFFFFFFF else hi}}}, {sig.get("nominal", 0)}}},'
+                           f'  // {sig["name"]}')
+
     # --- Format input pool ---
     input_pool_str = ', '.join(str(v) for v in input_pool)
 
@@ -660,8 +963,9 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
     txt.append('')
 
     # Clocks struct
-    txt.append('struct Clocks : clocktree::ClockTreeBase {')
+    txt.append(f'struct Clocks : clocktree::ClockTreeBase<{sig_typ}> {{')
     txt.append(f'    using S = Signals;')
+    txt.append(f'    using Id = {sig_typ};')
     txt.append('')
 
     # State struct
@@ -681,7 +985,7 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
     txt.append('')
 
     # Input pool
-    txt.append(f'    static constexpr uint8_t input_pool_data[] = {{{input_pool_str}}};')
+    txt.append(f'    static constexpr Id input_pool_data[] = {{{input_pool_str}}};')
     txt.append('')
 
     # Value tables
@@ -692,26 +996,64 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
     txt.append('')
 
     # Signal table
-    txt.append(f'    static constexpr clocktree::Signal signal_table[] = {{')
+    txt.append(f'    static constexpr clocktree::Signal<Id> signal_table[] = {{')
     txt.extend(signal_lines)
     txt.append('    };')
     txt.append('')
 
+    # Evaluation order: every signal after all of its inputs
+    txt.append(f'    static constexpr Id topo_order[] = {{{topo_order_str}}};')
+    txt.append('')
+
+    # Register addressing: base of all word offsets, and the number of
+    # words read by one query for a single signal / the whole tree
+    txt.append(f'    static constexpr uintptr_t register_base = {register_base:#x};')
+    txt.append(f'    static constexpr size_t snapshot_words = {snapshot_words};')
+    txt.append(f'    static constexpr size_t register_words = {register_words};')
+    txt.append('')
+
+    # Longest chain of elements, sizes the evaluator's path array
+    txt.append(f'    static constexpr size_t max_depth = {depth};')
+    txt.append('')
+
+    # Reverse dependencies: the signals each signal feeds, and the signals
+    # whose element reads each register word
+    txt.append(f'    static constexpr uint16_t fanout_offsets[] = {{{fanout_offsets_str}}};')
+    txt.append(f'    static constexpr Id fanout_pool[] = {{{fanout_pool_str}}};')
+    txt.append('    static constexpr clocktree::FieldUse<Id> field_uses[] = {')
+    txt.extend(field_use_lines)
+    txt.append('    };')
+    txt.append('')
+
+    # Datasheet frequency limits and nominal frequency of every signal
+    txt.append('    static constexpr clocktree::Limits limits[] = {')
+    txt.extend(limit_lines)
+    txt.append('    };')
+    txt.append('')
+
+    # PLL solver paths, from the reference divider input to a PLL output
+    if pll_path_lines:
+        txt.append('    static constexpr clocktree::PllPath<Id> pll_paths[] = {')
+        txt.extend(pll_path_lines)
+        txt.append('    };')
+        txt.append('')
+
     # Mutable state
     txt.append(f'    uint32_t state_data[{max(state_count, 1)}] = {{{state_defaults_str}}};')
     txt.append('')
 
     # Constructor wires up base class pointers
     if state_names:
-        txt.append('    Clocks(State st) {')
+        txt.append('    constexpr Clocks(State st) {')
         for i, name in enumerate(state_names):
             txt.append(f'        state_data[{i}] = st.{name};')
     else:
-        txt.append('    Clocks() {')
+        txt.append('    constexpr Clocks() {')
     txt.append('        signals = signal_table;')
     txt.append(f'        signal_count = sizeof(signal_table) / sizeof(signal_table[0]);')
     txt.append('        types = type_table;')
     txt.append('        input_pool = input_pool_data;')
+    txt.append('        order = topo_order;')
     txt.append('        value_tables = value_tables_data;')
     txt.append('        state = state_data;')
     txt.append('    }')
@@ -749,7 +1091,9 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
         'module;',
         '',
         '#include <cstdint>',
+        '#include <initializer_list>',
         '#include <span>',
+        '#include <type_traits>',
         '',
         f'export module {module_name};',
         '',
@@ -760,6 +1104,26 @@ def generate_header(yaml_path, namespace, hpp_path, module_name=None):
     ]
     cppm_path.write_text('\n'.join(cppm))
 
+    # Size report of the constant tables, aggregated across trees by the
+    # clocktree_footprint_report() CMake function
+    id_size = 1 if sig_typ == 'uint8_t' else 2
+    tables = {
+        'type_table': (len(active_types) + 1, target_sizeof['clocktree::BlockType']),
+        'input_pool_data': (len(input_pool), id_size),
+        'value_tables_data': (max(len(value_table_pool), 1), 4),
+        'signal_table': (len(signals), 4 if id_size == 1 else 6),
+        'topo_order': (len(topo_order), id_size),
+        'fanout_offsets': (len(fanout_offsets), 2),
+        'fanout_pool': (max(len(fanout_pool), 1), id_size),
+        'field_uses': (len(field_use_lines), target_sizeof['clocktree::FieldUse']),
+        'limits': (len(limit_lines), target_sizeof['clocktree::Limits']),
+        'pll_paths': (len(pll_path_lines), target_sizeof['clocktree::PllPath']),
+    }
+    report = footprint(Path(hpp_path).stem, namespace, id_size, tables, active_types,
+                       len(signals), state_count)
+    Path(hpp_path).with_suffix('.footprint.json').write_text(json.dumps(report, indent=2) + '\n')
+
 
 if __name__ == "__main__":
-    generate_header(sys.argv[1], sys.argv[2], sys.argv[3]+sys.argv[4])
+    generate_header(sys.argv[1], sys.argv[2], sys.argv[3]+sys.argv[4],
+                    id_type=sys.argv[5] if len(sys.argv) > 5 else None)
@@ -1,6 +1,9 @@
 # Unified header generator — dispatches to the appropriate generator based on model content.
 #
-# Usage: python3 generate_header.py <model.yaml> <namespace> <model_name> <suffix>
+# Usage: python3 generate_header.py <model.yaml> <namespace> <model_name> <suffix> [<id_type>]
+#
+# <id_type> forces the signal ID type of a clock tree (uint8_t or uint16_t)
+# instead of the narrowest that fits; it is ignored for other models.
 #
 # Model type detection:
 #   - 'registers' key  → peripheral block header (generate_peripheral_header)
@@ -55,7 +58,8 @@ elif 'instances' in model:
 
 elif 'signals' in model:
     from generate_clocktree_header import generate_header
-    generate_header(sys.argv[1], sys.argv[2], sys.argv[3]+sys.argv[4], modid)
+    generate_header(sys.argv[1], sys.argv[2], sys.argv[3]+sys.argv[4], modid,
+                    id_type=sys.argv[5] if len(sys.argv) > 5 else None)
 
 else:
     keys = ', '.join(model.keys())
@@ -100,6 +100,37 @@ def _wrap_array_type(elem_type, dims):
     return elem_type
 
 
+# SVD modifiedWriteValues that make writing a field a side effect, in the
+# order of the members of hwreg's SideEffects.  The others ('clear', 'set',
+# 'modify') don't occur in the models.
+_WRITE_EFFECTS = ['oneToClear', 'oneToSet', 'oneToToggle', 'zeroToClear', 'zeroToSet', 'zeroToToggle']
+
+
+def _side_effects(reg, bits):
+    """Return the SideEffects initializer of a register, or '' if accessing
+    it has no side effects.
+
+    Fields inherit modifiedWriteValues, readAction and access from the
+    register.  The masks list the bits of the fields with each side effect;
+    `plain` lists the bits of writable fields with neither a write nor a
+    read side effect.
+    """
+    masks = {name: 0 for name in _WRITE_EFFECTS + ['onRead', 'plain']}
+    for field in reg.get('fields', []):
+        mask = ((1 << field.get('bitWidth', 1)) - 1) << field['bitOffset']
+        write = field.get('modifiedWriteValues', reg.get('modifiedWriteValues'))
+        if write in masks:
+            masks[write] |= mask
+        if field.get('readAction', reg.get('readAction')):
+            masks['onRead'] |= mask
+        elif write not in masks and field.get('access', reg.get('access', 'read-write')) != 'read-only':
+            masks['plain'] |= mask
+    if not any(masks[name] for name in _WRITE_EFFECTS + ['onRead']):
+        return ''
+    full = (1 << bits) - 1
+    return ', '.join(f'.{name} = {mask & full:#x}' for name, mask in masks.items() if mask)
+
+
 class PerFormatter:
     def __init__(self, **keywords):
         self.enumTemplate      = Template(keywords.get('enum'     , '\n\t/** $description */\n\t$name = $value,'))
@@ -107,6 +138,8 @@ class PerFormatter:
         self.regEnumsTemplate  = Template(keywords.get('regEnums' , '\ninline namespace ${name}_ {$enums} // namespace ${name}_\n'))
         self.bitfieldTemplate  = Template(keywords.get('bitfield' , '\n\t/** $description */\n\t$type $name:$width;'))
         self.resBitsTemplate   = Template(keywords.get('resBits'  , '\n\t$type _$res:$width;\t// reserved'))
+        self.resetTemplate     = Template(keywords.get('reset'    , '\n\t/** Register value after reset */\n\tstatic constexpr $type resetValue = $value;'))
+        self.effectsTemplate   = Template(keywords.get('effects'  , '\n\t/** Bits with side effects on write or read */\n\tstatic constexpr SideEffects sideEffects{$effects};'))
         self.typeTemplate      = Template(keywords.get('type'     , 'HwReg<struct $name>'))
         self.resBytesTemplate  = Template(keywords.get('resBytes' , '\n\tuint8_t _$res[$bytes];\t// reserved'))
         self.fieldTemplate     = Template(keywords.get('field'    , '\n\t/** $description */\n\t$type $name;'))
@@ -115,6 +148,8 @@ class PerFormatter:
         self.addressTemplate   = Template(keywords.get('address'  , '\t$type$usage;\t// offset = $offset, size = $size\n'))
         self.interruptTemplate = Template(keywords.get('interrupt', '\tException ex$name;\t//!< $description\n'))
         self.parameterTemplate = Template(keywords.get('parameter', '\tuint16_t $name:$bits;\t//!< $description\n'))
+        self.aliasesTemplate   = Template(keywords.get('aliases'  , '\tAtomicAliases aliases;\t//!< Atomic access aliases of the registers, if any\n'))
+        self.bitBandTemplate   = Template(keywords.get('bitBand'  , '\tbool bitBand;\t//!< Registers are in the bit-band region\n'))
         self.headerTemplate    = Template(keywords.get('header', """
 $prefix
 namespace ${name} {$enums
@@ -125,7 +160,7 @@ EXPORT struct $name {$regs
 
 /** Integration of peripheral in the SoC. */
 EXPORT struct Intgr {
-$params$ints$blocks};
+$params$ints$blocks$access};
 } // namespace ${name}
 $postfix"""))
                                                        
@@ -139,13 +174,16 @@ $postfix"""))
             list.append(txt)
         return ''.join(list)
         
-    def formatFieldList(self, fields:list, type:str, sname:str=''):
+    def formatFieldList(self, fields:list, type:str, sname:str='', bits:int=0):
         """ Generate bitfield list
 
         `sname` is the enclosing struct (register) name; it qualifies enum
         type names so that two registers with same-named fields produce
         distinct C++ enum types (e.g. CNTL_IE vs MASK_IE rather than two
         unrelated `IE_e`).
+        `bits` is the register width; unused bits above the last field are
+        filled with a reserved field, so that every bit of the struct has a
+        defined value (e.g. when HwReg::modify() converts it to an integer).
         Returns:
         - the formatted list of bitfields as a multiline string
         - the formatted list of enum definitions as a multiline string
@@ -175,6 +213,8 @@ $postfix"""))
                 pos = offset
             txt += line
             pos += width
+        if bits > pos:
+            txt += self.resBitsTemplate.substitute(type=type, res=res, width=bits-pos)
         return txt, enums
                 
     def formatRegisterList(self, reglist:list, defaultType:str, padToSize:int, defaultSize:int, structPrefix:str='', blockName:str=''):
@@ -249,8 +289,10 @@ $postfix"""))
                     typeName = structPrefix + memberName
                     names = ",".join(reg['name'] % item for item in tokens)
                 else:
-                    # Single register, or HwArray-wrapped array.
-                    memberName = reg['name'].replace('[%s]', '').replace('%s', '')
+                    # Single register, or HwArray-wrapped array.  Names like
+                    # the RP2040 RTC's '0' and '1' get the same prefix as
+                    # fields, see _safe_name().
+                    memberName = _safe_name(reg['name'].replace('[%s]', '').replace('%s', ''))
                     typeName = structPrefix + memberName
                     names = memberName
                 # Avoid clashing the bitfield struct name with the peripheral
@@ -260,7 +302,14 @@ $postfix"""))
                 size = reg.get('size', defaultSize * 8)
                 type = reg.get('dataType', 'uint%s_t' % size)
                 if 'fields' in reg and reg['fields']:
-                    fields, enum = self.formatFieldList(reg['fields'], type, sname=typeName)
+                    fields, enum = self.formatFieldList(reg['fields'], type, sname=typeName, bits=size)
+                    if 'resetValue' in reg:
+                        reset = reg['resetValue']
+                        reset = (int(reset, 0) if isinstance(reset, str) else reset) & ((1 << size) - 1)
+                        fields += self.resetTemplate.substitute(type=type, value=f'{reset:#x}')
+                    effects = _side_effects(reg, size)
+                    if effects:
+                        fields += self.effectsTemplate.substitute(effects=effects)
                     enums += self.regEnumsTemplate.substitute(reg, name=typeName, enums=enum) if enum else ''
                     structs += self.fieldsTemplate.substitute(reg, name=typeName, fields=fields, description=description)
                     regType = self.typeTemplate.substitute(reg, name=typeName)
@@ -305,16 +354,20 @@ $postfix"""))
     def formatIntegrationList(self, per:dict):
         """ Generate definitions for the parameterization of a peripheral """
         blocks = ''
+        access = ''
         for block in per.get('addressBlocks', []):
             type = (f'HwPtr<struct {per['name']} volatile> ') if block['usage'] == 'registers' else 'std::span<std::byte> '
             blocks += self.addressTemplate.substitute(block, type=type)
+            if block['usage'] == 'registers':
+                access = self.aliasesTemplate.substitute() + self.bitBandTemplate.substitute()
         ints = ''
+        # Descriptions go into line comments, so they must be a single line.
         for int in per.get('interrupts', []):
-            desc = int.get('description', '')
+            desc = ' '.join(int.get('description', '').split())
             ints += self.interruptTemplate.substitute(int, description=desc)
         params = ''
         for par in per.get('params', []):
-            desc = par.get('description', '')
+            desc = ' '.join(par.get('description', '').split())
             ptype = par.get('type', 'int')   # `type:` is optional; defaults to int
             if 'bits' in par:
                 # Explicit bit-width wins over any derivation; some authors
@@ -328,15 +381,15 @@ $postfix"""))
             else:
                 ctype = {'string': 'const char*'}.get(ptype, 'uint32_t')
                 params += f'\t{ctype} {par["name"]};\t//!< {desc}\n'
-        return blocks, ints, params
+        return blocks, ints, params, access
 
     def formatPeripheral(self, per:dict, prefix:str, postfix:str):
         """ Generate definitions for a peripheral """
         defaultSize = per.get('size', 32) >> 3
         types, regs, size, enums = self.formatRegisterList(per['registers'], 'uint32_t', 0, defaultSize, blockName=per.get('name', ''))
-        blocks, ints, params = self.formatIntegrationList(per)
+        blocks, ints, params, access = self.formatIntegrationList(per)
         description = per.get('description', '')
-        return self.headerTemplate.substitute(per, blocks=blocks, ints=ints, params=params, regs=regs, enums=enums, types=types, description=description, size=size, prefix=prefix, postfix=postfix)
+        return self.headerTemplate.substitute(per, blocks=blocks, ints=ints, params=params, access=access, regs=regs, enums=enums, types=types, description=description, size=size, prefix=prefix, postfix=postfix)
     
          
 prefixTemplate = Template("""// File was generated, do not edit!
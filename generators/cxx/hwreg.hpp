@@ -57,6 +57,116 @@ template<typename T> concept RegBitfield = requires(T x) {
     std::is_integral_v<uint<sizeof(T)>>;
 };
 
+/** Bits of a register whose access has side effects.
+ *
+ * Each mask lists the bits of the fields with one kind of side effect, from
+ * the `modifiedWriteValues` and `readAction` of the model. The generator emits
+ * them as a `sideEffects` member of the bitfield struct of registers that
+ * have such fields.
+ */
+struct SideEffects {
+    uint64_t oneToClear = 0;    //!< Writing 1 clears the bit, 0 has no effect
+    uint64_t oneToSet = 0;      //!< Writing 1 sets the bit, 0 has no effect
+    uint64_t oneToToggle = 0;   //!< Writing 1 toggles the bit, 0 has no effect
+    uint64_t zeroToClear = 0;   //!< Writing 0 clears the bit, 1 has no effect
+    uint64_t zeroToSet = 0;     //!< Writing 0 sets the bit, 1 has no effect
+    uint64_t zeroToToggle = 0;  //!< Writing 0 toggles the bit, 1 has no effect
+    uint64_t onRead = 0;        //!< Reading changes the bit
+    uint64_t plain = 0;         //!< Writable bits without side effects
+
+    //! Bits whose write has a side effect.
+    constexpr uint64_t onWrite() const noexcept {
+        return oneToClear | oneToSet | oneToToggle | zeroToClear | zeroToSet | zeroToToggle;
+    }
+
+    //! Value of the bits whose write has a side effect that has none.
+    constexpr uint64_t neutral() const noexcept {
+        return zeroToClear | zeroToSet | zeroToToggle;
+    }
+};
+
+//! Side effects of accessing a register with bitfield struct R; none unless
+//! R has a `sideEffects` member.
+template<typename R> constexpr SideEffects sideEffects{};
+template<typename R> requires requires { R::sideEffects; }
+constexpr SideEffects sideEffects<R> = R::sideEffects;
+
+/** Address offsets of the atomic access aliases of a register, 0 if absent.
+ *
+ * Some chips, like the RP2040 and RP2350, map each peripheral register a
+ * second time for every kind of alias, where a write XORs, sets or clears the
+ * written bits instead of storing them. The chip header puts the offsets
+ * into the `aliases` member of the Intgr of every instance that has them,
+ * which is passed to HwReg::set_bits() and friends as template argument.
+ */
+struct AtomicAliases {
+    std::uintptr_t toggle = 0;  //!< Writing 1 toggles the bit, 0 has no effect
+    std::uintptr_t set = 0;     //!< Writing 1 sets the bit, 0 has no effect
+    std::uintptr_t clear = 0;   //!< Writing 1 clears the bit, 0 has no effect
+};
+
+/** Pointer to a hardware register block.
+ *
+ * The motivation for this template is the fact that it is illegal since C++20
+ * to use reinterpret_cast to initialize constexpr data. This makes it almost
+ * impossible to initialize a constexpr pointer with a numeric value, as
+ * required for hardware registers with a known address. The workaround used
+ * here is to use reinterpret_cast when the address is used, rather than when it
+ * is initialized. Note that the constructor is constexpr, while the operator*
+ * isn't. The initialization is done with a plain integer, so no explicit casts
+ * need to be done by the user.
+ */
+template<typename T>
+struct HwPtr {
+    using element_type = T;
+    constexpr HwPtr(std::uintptr_t addr) : addr_{addr} {}
+    T &operator*() const noexcept { return *reinterpret_cast<T*>(addr_); }
+    T *operator->() const noexcept { return reinterpret_cast<T*>(addr_); }
+private:
+    std::uintptr_t addr_;
+};
+
+/** Bit-band alias of a single bit, on Cortex-M3 and Cortex-M4 cores.
+ *
+ * These cores map each bit of the first MB of the SRAM (0x2000'0000) and the
+ * peripheral (0x4000'0000) region to a word of an alias region 32 MB above.
+ * Reading the word returns the bit, writing it changes just that bit with a
+ * single store, which needs neither a read-modify-write nor a critical section.
+ * The alias address is computed when the BitBand is constructed, at compile
+ * time if the register address is a constant. The chip header sets the
+ * `bitBand` member of the Intgr of every instance in such a region.
+ */
+class BitBand {
+public:
+    //! Whether the byte at `addr` has a bit-band alias.
+    static constexpr bool covers(std::uintptr_t addr) noexcept {
+        return (addr & 0xFFF0'0000u) == 0x2000'0000u || (addr & 0xFFF0'0000u) == 0x4000'0000u;
+    }
+
+    //! Address of the alias word of bit `bit` of the little endian word at `addr`.
+    static constexpr std::uintptr_t alias(std::uintptr_t addr, unsigned bit) noexcept {
+        std::uintptr_t region = addr & 0xF000'0000u;
+        return region + 0x0200'0000u + (addr - region) * 32 + bit * 4;
+    }
+
+    constexpr BitBand(std::uintptr_t addr, unsigned bit) noexcept : word_{alias(addr, bit)} {}
+
+    /** Read the bit */
+    bool get() const noexcept { return *word_ & 1; }
+
+    /** Read the bit */
+    operator bool() const noexcept { return get(); }
+
+    /** Write the bit */
+    void set(bool val) const noexcept { *word_ = val; }
+
+    /** Write the bit */
+    void operator=(bool val) const noexcept { set(val); }
+
+private:
+    HwPtr<std::uint32_t volatile> word_;
+};
+
 /** The HwReg template is meant to represent hardware registers.
  *
  * The template encapsulates the bitfields and the endianness of the register,
@@ -66,13 +176,15 @@ template<typename T> concept RegBitfield = requires(T x) {
  * deliberately not supported, because it leads to access patterns that are
  * obscure. You want to make obvious when a register is read or written, how
  * often and in what order, because reading or writing a hardware register often
- * has side effects.
+ * has side effects. The one exception is modify(), which names the
+ * read-modify-write it performs and does exactly one read and one write.
  */
 template<RegBitfield R, std::endian E = std::endian::native>
 struct HwReg {
     using BitField = R;
     using Native = uint<sizeof(R)>;
     static constinit std::endian const endian = E;
+    static constexpr SideEffects effects = sideEffects<R>;
 
     HwReg(HwReg &&) = delete;
 
@@ -188,6 +300,165 @@ struct HwReg {
         set(val);
     }
 
+    //! Bits a field update leaves alone, and the bits it sets.
+    struct Masks {
+        Native keep;
+        Native bits;
+    };
+
+    /** Return the masks of a field update.
+     * `f` is applied to an all-zero and an all-one bitfield struct. Bits that
+     * differ afterwards are those it leaves alone, the others are what it
+     * assigns. `f` must therefore only assign fields, not read them.
+     */
+    template<typename F> static constexpr Masks masks(F &&f) noexcept {
+        BitField zeros = std::bit_cast<BitField>(Native(0));
+        BitField ones = std::bit_cast<BitField>(Native(~Native(0)));
+        f(zeros);
+        f(ones);
+        Native bits = std::bit_cast<Native>(zeros);
+        return {Native(std::bit_cast<Native>(ones) ^ bits), bits};
+    }
+
+    /** Modify fields with one read and one write, e.g.
+     * `r.modify([](auto &b) { b.EN = 1; b.PSC = 3; })`.
+     * The register is read once and written once with `(old & keep) | bits`,
+     * see masks(). With constant field values the masks are constants, and
+     * the update is a load, an AND, an OR and a store.
+     *
+     * Registers with side effects on read or write have no modify(): writing
+     * back a pending write-1-to-clear flag would acknowledge it, and reading a
+     * clear-on-read field would lose its value. Use clear() or set() instead.
+     */
+    template<typename F> void modify(F &&f) volatile noexcept
+        requires (!effects.onWrite() && !effects.onRead) {
+        Masks m = masks(f);
+        set(Native((val() & m.keep) | m.bits));
+    }
+
+    /** Modify fields with one read and one write, see above. */
+    template<typename F> void modify(F &&f) noexcept
+        requires (!effects.onWrite() && !effects.onRead) {
+        Masks m = masks(f);
+        set(Native((val() & m.keep) | m.bits));
+    }
+
+    /** Clear the flags in `flags`, in fields that are cleared by writing 1
+     * or 0 to them, e.g. status flags that acknowledge an interrupt.
+     * Other fields with write side effects are written the value that has
+     * none, so no other flag is cleared. If the register has no writable
+     * fields besides these, this is a single store without a read;
+     * otherwise those fields are read and written back.
+     */
+    void clear(Native flags) volatile noexcept {
+        static_assert(effects.oneToClear || effects.zeroToClear,
+                      "clear() needs fields that are cleared by writing to them");
+        Native value = clearValue(flags);
+        if constexpr (effects.plain != 0) {
+            static_assert(!effects.onRead, "clear() would need to read a register with read side effects");
+            value |= Native(val() & effects.plain);
+        }
+        set(value);
+    }
+
+    /** Clear the flags in `flags`, see above. */
+    void clear(Native flags) noexcept {
+        static_assert(effects.oneToClear || effects.zeroToClear,
+                      "clear() needs fields that are cleared by writing to them");
+        Native value = clearValue(flags);
+        if constexpr (effects.plain != 0) {
+            static_assert(!effects.onRead, "clear() would need to read a register with read side effects");
+            value |= Native(val() & effects.plain);
+        }
+        set(value);
+    }
+
+    /** Clear the flags set in the bitfield struct `flags`, see above. */
+    void clear(BitField flags) volatile noexcept {
+        clear(std::bit_cast<Native>(flags));
+    }
+
+    /** Clear the flags set in the bitfield struct `flags`, see above. */
+    void clear(BitField flags) noexcept {
+        clear(std::bit_cast<Native>(flags));
+    }
+
+    /** Return the value clear() writes to the fields with write side
+     * effects: 1 to the write-1-to-clear bits in `flags`, 0 to the
+     * write-0-to-clear bits in `flags`, and the neutral value to all others.
+     */
+    static constexpr Native clearValue(Native flags) noexcept {
+        return Native((effects.neutral() | (flags & effects.oneToClear)) & ~(flags & effects.zeroToClear));
+    }
+
+    /** Write the reset value with fields changed by `f`, without reading the
+     * register, e.g. `r.write_from_reset([](auto &b) { b.EN = 1; })`.
+     * Unlike a bitfield struct initialized to zero, the fields `f` leaves
+     * alone keep their reset defaults. Requires the `resetValue` that the
+     * generator emits for registers with a reset value in the model.
+     */
+    template<typename F> void write_from_reset(F &&f) volatile noexcept
+        requires requires { BitField::resetValue; } {
+        BitField b = std::bit_cast<BitField>(Native(BitField::resetValue));
+        f(b);
+        set(b);
+    }
+
+    /** Write the reset value with fields changed by `f`, see above. */
+    template<typename F> void write_from_reset(F &&f) noexcept
+        requires requires { BitField::resetValue; } {
+        BitField b = std::bit_cast<BitField>(Native(BitField::resetValue));
+        f(b);
+        set(b);
+    }
+
+    /** Set the bits in `mask` with a single store to the atomic set alias
+     * `A.set`, e.g. `r.set_bits<i_DMA.aliases>(1u << 5)` with the Intgr of the
+     * peripheral instance. The other bits are left alone, even if another core
+     * or a DMA changes them at the same time, which would be lost by a
+     * modify(). Only for chips with atomic aliases, see AtomicAliases.
+     */
+    template<AtomicAliases A> void set_bits(Native mask) volatile noexcept {
+        static_assert(A.set != 0, "register has no atomic set alias");
+        writeAlias(A.set, mask);
+    }
+
+    /** Clear the bits in `mask` with a single store to the atomic clear
+     * alias `A.clear`, see set_bits().
+     */
+    template<AtomicAliases A> void clear_bits(Native mask) volatile noexcept {
+        static_assert(A.clear != 0, "register has no atomic clear alias");
+        writeAlias(A.clear, mask);
+    }
+
+    /** Toggle the bits in `mask` with a single store to the atomic XOR
+     * alias `A.toggle`, see set_bits().
+     */
+    template<AtomicAliases A> void toggle_bits(Native mask) volatile noexcept {
+        static_assert(A.toggle != 0, "register has no atomic XOR alias");
+        writeAlias(A.toggle, mask);
+    }
+
+    /** Return the bit-band alias of the single-bit field that `f` assigns,
+     * e.g. `r.bit_band<i_GPIOA.bitBand>([](auto &b) { b.EN = 1; }) = true`
+     * with the Intgr of the peripheral instance. `f` is only used to find the
+     * field, see masks(), and must not capture anything. Only for instances
+     * the chip header places in a bit-band region, see BitBand.
+     *
+     * The core writes the alias with a locked read-modify-write of the whole
+     * register, so registers with side effects are rejected for the same
+     * reasons as by modify().
+     */
+    template<bool InBitBand, typename F> BitBand bit_band(F &&) volatile const noexcept {
+        static_assert(InBitBand, "register is not in a bit-band region");
+        static_assert(!effects.onWrite() && !effects.onRead,
+                      "bit-band access to a register with side effects, use clear() or set()");
+        static_assert(endian == std::endian::little, "bit-band alias of a big endian register");
+        constexpr Native field = Native(~masks(std::remove_cvref_t<F>{}).keep);
+        static_assert(std::has_single_bit(field), "bit_band() needs a single-bit field");
+        return {reinterpret_cast<std::uintptr_t>(&reg_), unsigned(std::countr_zero(field))};
+    }
+
     /** Return a reference to the register's bitfield representation.
      * Keep in mind that this may need to be byteswapped on access.
      */
@@ -221,27 +492,16 @@ struct HwReg {
     }
 
     Native reg_;
-};
 
-/** Pointer to a hardware register block.
- *
- * The motivation for this template is the fact that it is illegal since C++20
- * to use reinterpret_cast to initialize constexpr data. This makes it almost
- * impossible to initialize a constexpr pointer with a numeric value, as
- * required for hardware registers with a known address. The workaround used
- * here is to use reinterpret_cast when the address is used, rather than when it
- * is initialized. Note that the constructor is constexpr, while the operator*
- * isn't. The initialization is done with a plain integer, so no explicit casts
- * need to be done by the user.
- */
-template<typename T>
-struct HwPtr {
-    using element_type = T;
-    constexpr HwPtr(std::uintptr_t addr) : addr_{addr} {}
-    T &operator*() const noexcept { return *reinterpret_cast<T*>(addr_); }
-    T *operator->() const noexcept { return reinterpret_cast<T*>(addr_); }
 private:
-    std::uintptr_t addr_;
+    //! Write `val` to the alias of this register at `offset`.
+    void writeAlias(std::uintptr_t offset, Native val) volatile noexcept {
+        auto alias = reinterpret_cast<Native volatile *>(reinterpret_cast<std::uintptr_t>(&reg_) + offset);
+        if constexpr (endian != std::endian::native)
+            *alias = byteswap(val);
+        else
+            *alias = val;
+    }
 };
 
 //! Type for representing exceptions/interrupts.
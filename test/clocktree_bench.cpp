@@ -0,0 +1,151 @@
+// host benchmark for the clock-tree interpreter
+//
+// Compares N separate getFrequency() calls against one getFrequencies() query,
+// against N compile-time specialized getFrequency<S>() calls for the same N
+// signals, and against one evaluateAll() sweep over the whole tree, on the
+// SAM_Gen1 and H745_H757 clock trees, and checks that all four give the same
+// frequencies.
+//
+// The trees read their registers through the RegisterImage backend, from a
+// fixed pseudo-random register image in ordinary memory.
+//
+// With CLOCKTREE_WIDE_IDS defined, SAM_Gen1 is the copy generated with
+// 16-bit signal IDs.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+#if REGISTERS_MODULE
+#if CLOCKTREE_WIDE_IDS
+import microchip16.SAM_Gen1_clocks;
+#else
+import microchip.SAM_Gen1_clocks;
+#endif
+import stm32h7.H745_H757_clocks;
+#else
+#if CLOCKTREE_WIDE_IDS
+#include "microchip16/SAM_Gen1_clocks.hpp"
+#else
+#include "microchip/SAM_Gen1_clocks.hpp"
+#endif
+#include "stm32h7/H745_H757_clocks.hpp"
+#endif
+#include "register_image.hpp"
+
+#if CLOCKTREE_WIDE_IDS
+// SAM_Gen1 generated with 16-bit signal IDs
+namespace microchip = microchip16;
+static_assert(sizeof(microchip::Clocks::Id) == 2);
+#endif
+
+namespace {
+
+/// Address ranges holding the clock registers of the benchmarked trees.
+constexpr Window windows[] = {
+    {0x400E0000, 0x2000},   // SAME70 UTMI, PMC, SUPC
+    {0x50000000, 0x10000},  // H7 DSIHOST
+    {0x58020000, 0x10000},  // H7 RCC, PWR
+};
+
+WindowImage image{windows};
+
+/// Average run time of f() in nanoseconds.
+template<typename F> double measure(unsigned rounds, F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned r = 0; r < rounds; ++r)
+        f();
+    std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+    return dt.count() / rounds;
+}
+
+template<auto const& sigs, typename CT, size_t... I>
+void specialized(CT const& ct, std::vector<uint32_t>& out, std::index_sequence<I...>) {
+    ((out[I] = ct.template getFrequency<sigs[I]>()), ...);
+}
+
+template<typename Clocks, auto const& sigs>
+bool bench(char const* name, typename Clocks::State st) {
+    using CT = clocktree::ClockTree<Clocks, clocktree::RegisterImage>;
+    CT ct{clocktree::RegisterImage{image.regions}, st};
+    std::vector<uint32_t> single(std::size(sigs)), batch(std::size(sigs)), fixed(std::size(sigs));
+    static uint32_t all[CT::num_signals];
+    constexpr unsigned rounds = 20000;
+
+    double t_single = measure(rounds, [&] {
+        for (size_t i = 0; i < std::size(sigs); ++i)
+            single[i] = ct.getFrequency(sigs[i]);
+    });
+    double t_batch = measure(rounds, [&] {
+        ct.getFrequencies(sigs, batch);
+    });
+    double t_fixed = measure(rounds, [&] {
+        specialized<sigs>(ct, fixed, std::make_index_sequence<std::size(sigs)>());
+    });
+    double t_all = measure(rounds, [&] {
+        ct.evaluateAll(all);
+    });
+
+    unsigned running = 0;
+    for (auto f : batch)
+        running += f != 0;
+    std::printf("%-10s %2zu signals (%2u running): getFrequency x%zu %8.0f ns, "
+                "getFrequencies %8.0f ns (speedup %.2f), getFrequency<S> x%zu %8.0f ns (speedup %.2f), "
+                "evaluateAll (%zu signals) %8.0f ns\n",
+                name, std::size(sigs), running, std::size(sigs), t_single, t_batch, t_single / t_batch,
+                std::size(sigs), t_fixed, t_single / t_fixed, CT::num_signals, t_all);
+    if (single != batch) {
+        std::printf("%s: batched frequencies differ from single queries\n", name);
+        return false;
+    }
+    if (single != fixed) {
+        std::printf("%s: specialized frequencies differ from single queries\n", name);
+        return false;
+    }
+    for (size_t i = 0; i < std::size(sigs); ++i) {
+        if (all[size_t(sigs[i])] != single[i]) {
+            std::printf("%s: evaluateAll frequencies differ from single queries\n", name);
+            return false;
+        }
+    }
+    return true;
+}
+
+using MS = microchip::Signals;
+constexpr MS sam_sigs[] = {
+    MS::periph_clk_uart0, MS::periph_clk_uart1, MS::periph_clk_smc, MS::periph_clk_pioa,
+    MS::periph_clk_piob, MS::periph_clk_pioc, MS::periph_clk_usart0, MS::periph_clk_usart1,
+    MS::periph_clk_usart2, MS::periph_clk_piod, MS::periph_clk_pioe, MS::periph_clk_hsmci,
+    MS::periph_clk_twihs0, MS::periph_clk_twihs1, MS::periph_clk_spi0, MS::periph_clk_ssc,
+    MS::periph_clk_tc0_ch0, MS::periph_clk_tc0_ch1, MS::periph_clk_tc0_ch2, MS::periph_clk_afec0,
+    MS::periph_clk_dacc, MS::periph_clk_pwm0, MS::periph_clk_usbhs, MS::periph_clk_mcan0,
+    MS::periph_clk_mcan1, MS::periph_clk_gmac, MS::periph_clk_qspi, MS::periph_clk_xdmac,
+    MS::pck4, MS::pck5, MS::usb_48m, MS::gck_i2sc0,
+};
+
+using HS = stm32h7::Signals;
+constexpr HS h7_sigs[] = {
+    HS::sdmmc_ker_ck, HS::quadspi_ker_ck, HS::fmc_ker_ck, HS::fdcan_ker_ck,
+    HS::spi123_ker_ck, HS::spi45_ker_ck, HS::spi6_ker_ck, HS::sai1_ker_ck,
+    HS::sai23_ker_ck, HS::sai4a_ker_ck, HS::sai4b_ker_ck, HS::usart16_ker_ck,
+    HS::usart234578_ker_ck, HS::lpuart1_ker_ck, HS::i2c123_ker_ck, HS::i2c4_ker_ck,
+    HS::lptim1_ker_ck, HS::lptim2_ker_ck, HS::lptim345_ker_ck, HS::usb_ker_ck,
+    HS::adc_ker_ck, HS::rng_ker_ck, HS::spdif_ker_ck, HS::cec_ker_ck,
+    HS::swpmi_ker_ck, HS::dfsdm1_ker_ck, HS::rcc_hclk, HS::rcc_pclk1,
+    HS::rcc_pclk2, HS::rcc_pclk3, HS::rcc_pclk4, HS::rcc_timx_ker_ck,
+};
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    for (uint32_t seed : {1u, 2u, 3u}) {
+        image.fill(seed);
+        ok &= bench<microchip::Clocks, sam_sigs>("SAM_Gen1", {.stateXTAL32K = 32768, .stateMAIN_XTAL = 12'000'000});
+        ok &= bench<stm32h7::Clocks, h7_sigs>("H745_H757", {.freqHSE = 25'000'000, .freqLSE = 32768});
+    }
+    return ok ? 0 : 1;
+}
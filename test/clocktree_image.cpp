@@ -0,0 +1,241 @@
+// host checks of clock-tree queries on a register image
+//
+// Runs the SAM_Gen1 clock tree on a PMC register image in ordinary memory,
+// changes the image the way firmware would change the registers, and checks
+// what the queries report, with and without the frequency cache. The
+// H745_H757 tree checks the fixed-point precision policy on a fractional PLL.
+//
+// With CLOCKTREE_WIDE_IDS defined, SAM_Gen1 is the copy generated with
+// 16-bit signal IDs.
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#if REGISTERS_MODULE
+#if CLOCKTREE_WIDE_IDS
+import microchip16.SAM_Gen1_clocks;
+#else
+import microchip.SAM_Gen1_clocks;
+#endif
+import stm32h7.H745_H757_clocks;
+#else
+#if CLOCKTREE_WIDE_IDS
+#include "microchip16/SAM_Gen1_clocks.hpp"
+#else
+#include "microchip/SAM_Gen1_clocks.hpp"
+#endif
+#include "stm32h7/H745_H757_clocks.hpp"
+#endif
+
+#if CLOCKTREE_WIDE_IDS
+// SAM_Gen1 generated with 16-bit signal IDs
+namespace microchip = microchip16;
+static_assert(sizeof(microchip::Clocks::Id) == 2);
+#endif
+
+namespace {
+
+using MS = microchip::Signals;
+using CT = clocktree::ClockTree<microchip::Clocks, clocktree::RegisterImage>;
+
+constexpr uintptr_t pmc_base = 0x400E0600;
+constexpr uintptr_t PMC_PCSR0 = 0x400E0610;
+constexpr uintptr_t CKGR_MOR = 0x400E0620;
+constexpr uintptr_t CKGR_PLLAR = 0x400E0628;
+constexpr uintptr_t PMC_MCKR = 0x400E0630;
+
+/// PMC registers: main crystal selected and running, MCK = MAINCK = 12 MHz.
+std::array<uint32_t, 0x40> pmc;
+clocktree::RegisterImage::Region const regions[] = {{pmc_base, pmc}};
+
+uint32_t& reg(uintptr_t addr) { return pmc[(addr - pmc_base) / 4]; }
+
+void reset() {
+    pmc = {};
+    reg(CKGR_MOR) = (1u << 24) | 1;
+    reg(PMC_MCKR) = 1;
+}
+
+CT tree() {
+    return CT{clocktree::RegisterImage{regions}, microchip::Clocks::State{.stateMAIN_XTAL = 12'000'000}};
+}
+
+bool check(bool ok, char const* what) {
+    if (!ok)
+        std::printf("failed: %s\n", what);
+    return ok;
+}
+
+/// Callbacks run and the frequency each saw before the change.
+struct Calls {
+    unsigned count = 0;
+    uint32_t old_freq = 0;
+};
+
+void record(clocktree::Subscription<MS>& sub, uint32_t old_freq) {
+    auto& calls = *static_cast<Calls*>(sub.context);
+    ++calls.count;
+    calls.old_freq = old_freq;
+}
+
+/// Subscribers are called once when their clock changes, and not for
+/// writes elsewhere in the tree or writes that change nothing.
+bool notifications() {
+    reset();
+    CT ct = tree();
+    Calls hclk_calls, mck_calls, slck_calls;
+    clocktree::Subscription<MS> hclk{MS::hclk, record, &hclk_calls};
+    clocktree::Subscription<MS> mck{MS::mck, record, &mck_calls};
+    clocktree::Subscription<MS> slck{MS::slck, record, &slck_calls};
+    ct.subscribe(hclk);
+    ct.subscribe(mck);
+    ct.subscribe(slck);
+
+    bool ok = true;
+    reg(PMC_MCKR) |= 1u << 4;           // PRES = /2, feeds HCLK and MCK
+    ct.update(PMC_MCKR, 0x70);
+    ok &= check(hclk_calls.count == 1 && hclk_calls.old_freq == 12'000'000 && hclk.frequency == 6'000'000,
+                "hclk notified of the prescaler change");
+    ok &= check(mck_calls.count == 1 && mck_calls.old_freq == 12'000'000 && mck.frequency == 6'000'000,
+                "mck notified of the prescaler change");
+
+    reg(PMC_MCKR) |= 1u << 8;           // MDIV = /2, feeds MCK only
+    ct.update(PMC_MCKR, 0x300);
+    ok &= check(hclk_calls.count == 1, "hclk not notified of the MCK divider change");
+    ok &= check(mck_calls.count == 2 && mck_calls.old_freq == 6'000'000 && mck.frequency == 3'000'000,
+                "mck notified of the MCK divider change");
+
+    ct.update(PMC_MCKR, 0x370);         // written again with the same value
+    ok &= check(hclk_calls.count == 1 && mck_calls.count == 2, "no notification without a change");
+    ok &= check(slck_calls.count == 0, "slck never notified");
+    return ok;
+}
+
+/// audit() reports the signals outside their datasheet limits, and only those.
+bool limits() {
+    reset();
+    CT ct = tree();
+    clocktree::Violation<MS> found[4];
+    bool ok = check(ct.audit(found) == 0, "no violation with the PLL stopped");
+
+    reg(CKGR_PLLAR) = (24u << 16) | 1;  // 12 MHz x 25 = 300 MHz
+    ok &= check(ct.audit(found) == 0, "no violation with PLLA at 300 MHz");
+
+    reg(CKGR_PLLAR) = (49u << 16) | 1;  // 12 MHz x 50 = 600 MHz, above 500 MHz
+    ok &= check(ct.audit(found) == 1 && found[0].signal == MS::pllack && found[0].frequency == 600'000'000,
+                "PLLA at 600 MHz reported");
+    ok &= check(ct.audit({}) == 1, "audit({}) counts the violation");
+    return ok;
+}
+
+/// activeClocks() holds the path of each running peripheral clock, and
+/// neither a stopped PLL nor one that feeds nothing running.
+bool active() {
+    reset();
+    reg(PMC_PCSR0) = 1u << 21;          // SPI0 clock enabled
+    CT ct = tree();
+    auto set = ct.activeClocks();
+    bool ok = check(set.contains(MS::periph_clk_spi0) && set.contains(MS::mck) && set.contains(MS::hclk)
+                    && set.contains(MS::mainck) && set.contains(MS::main_xtal_osc),
+                    "path of the SPI0 clock active");
+    ok &= check(!set.contains(MS::periph_clk_usart0), "disabled USART0 clock not active");
+    ok &= check(!set.contains(MS::pllack) && !set.contains(MS::plla_in), "stopped PLLA not active");
+
+    reg(CKGR_PLLAR) = (24u << 16) | 1;  // PLLA running, but MCK still from MAINCK
+    set = ct.activeClocks();
+    ok &= check(!set.contains(MS::pllack), "unused PLLA not active");
+
+    reg(PMC_MCKR) = 2;                  // MCK from PLLA
+    set = ct.activeClocks();
+    ok &= check(set.contains(MS::pllack) && set.contains(MS::plla_in), "PLLA feeding MCK active");
+    return ok;
+}
+
+/// evaluateWith() applies pending writes without touching the registers.
+bool overlay() {
+    reset();
+    CT ct = tree();
+    uint32_t mck = ct.getFrequency(MS::mck);
+    bool ok = check(ct.evaluateWith({{PMC_MCKR, 0x70, 0x10}}, MS::mck) == mck / 2, "PRES = /2 halves mck");
+    ok &= check(ct.evaluateWith({{PMC_MCKR, 0x70, 0x10}, {PMC_MCKR, 0x70, 0x20}}, MS::mck) == mck / 4,
+                "later writes to the same bits win");
+    ok &= check(ct.getFrequency(MS::mck) == mck && reg(PMC_MCKR) == 1, "registers unchanged");
+
+    clocktree::RegisterSetting const to_plla[] = {{CKGR_PLLAR, 0x07FF00FF, (24u << 16) | 1}, {PMC_MCKR, 0x3, 2}};
+    MS const sigs[] = {MS::pllack, MS::hclk, MS::mck};
+    uint32_t freqs[3];
+    ct.evaluateWith(to_plla, sigs, freqs);
+    ok &= check(freqs[0] == 300'000'000 && freqs[1] == 300'000'000 && freqs[2] == 300'000'000,
+                "several signals with PLLA selected");
+    return ok;
+}
+
+/// A cached tree answers from the cache until told about register writes,
+/// by invalidate() or by update() for the register written.
+bool cached() {
+    reset();
+    clocktree::CachedClockTree<microchip::Clocks, clocktree::RegisterImage> ct{
+        clocktree::RegisterImage{regions}, microchip::Clocks::State{.stateMAIN_XTAL = 12'000'000}};
+
+    bool ok = check(ct.getFrequency(MS::mck) == 12'000'000, "cached tree reads MCK");
+    reg(PMC_MCKR) |= 1u << 4;           // PRES = /2
+    ok &= check(ct.getFrequency(MS::mck) == 12'000'000, "cached MCK kept after a register write");
+    ct.invalidate();
+    ok &= check(ct.getFrequency(MS::mck) == 6'000'000, "MCK read again after invalidate()");
+
+    reg(PMC_MCKR) |= 1u << 8;           // MDIV = /2
+    ok &= check(ct.getFrequency(MS::mck) == 6'000'000, "cached MCK kept after another write");
+    ct.update(PMC_MCKR, 0x300);
+    ok &= check(ct.getFrequency(MS::mck) == 3'000'000, "MCK read again after update()");
+    return ok;
+}
+
+/// The Q32.32 policy keeps the fraction of a fractional PLL through the
+/// divider behind it, in every runtime query, where whole Hz truncate it.
+bool fractional() {
+    constexpr uintptr_t rcc_base = 0x58024400;
+    std::array<uint32_t, 0x10> rcc{};
+    rcc[0x00 / 4] = 1;                  // CR: HSION, HSIDIV = /1, 64 MHz
+    rcc[0x28 / 4] = 4u << 12;           // PLLCKSELR: PLLSRC = HSI, DIVM2 = 4
+    rcc[0x38 / 4] = (1u << 9) | 24;     // PLL2DIVR: DIVP2 = /2, DIVN2 = 25
+    rcc[0x3C / 4] = 1u << 3;            // PLL2FRACR: FRACN2 = 1
+    clocktree::RegisterImage::Region const rcc_regions[] = {{rcc_base, rcc}};
+    using HS = stm32h7::Signals;
+    clocktree::ClockTree<stm32h7::Clocks, clocktree::RegisterImage> hz{
+        clocktree::RegisterImage{rcc_regions}, stm32h7::Clocks::State{}};
+    clocktree::ClockTree<stm32h7::Clocks, clocktree::RegisterImage, clocktree::Q32_32> q32{
+        clocktree::RegisterImage{rcc_regions}, stm32h7::Clocks::State{}};
+
+    // 16 MHz x (25 + 1/8192) / 2 = 200'000'976.5625 Hz
+    bool ok = check(hz.getFrequency(HS::pll2_p_raw) == 200'000'976, "whole Hz truncated");
+    ok &= check(q32.getFrequency(HS::pll2_p_raw) == 200'000'977, "Q32.32 rounded once");
+    ok &= check(q32.getExactFrequency(HS::pll2_p_raw) == (uint64_t(200'000'976) << 32) + (uint64_t(9) << 28),
+                "Q32.32 keeps the fraction");
+
+    HS const sigs[] = {HS::vco2_ck, HS::pll2_p_raw};
+    uint32_t freqs[2];
+    q32.getFrequencies(sigs, freqs);
+    ok &= check(freqs[0] == 400'001'953 && freqs[1] == 200'000'977, "Q32.32 getFrequencies()");
+
+    // FRACN2 = 3: 16 MHz x (25 + 3/8192) / 2 = 200'002'929.6875 Hz
+    clocktree::RegisterSetting const frac3[] = {{rcc_base + 0x3C, 0xFFF8, 3u << 3}};
+    ok &= check(q32.evaluateWith(frac3, HS::pll2_p_raw) == 200'002'930, "Q32.32 evaluateWith()");
+    q32.evaluateWith(frac3, sigs, freqs);
+    ok &= check(freqs[0] == 400'005'859 && freqs[1] == 200'002'930, "Q32.32 evaluateWith() of several");
+    ok &= check(hz.evaluateWith(frac3, HS::pll2_p_raw) == 200'002'929, "whole Hz evaluateWith()");
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    ok &= notifications();
+    ok &= limits();
+    ok &= active();
+    ok &= overlay();
+    ok &= cached();
+    ok &= fractional();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// host dry run of a clock reconfiguration sequence
+//
+// Plans two clock configurations of the H745_H757 tree on a register image,
+// applies the first, and prints the steps sequence() orders for the move to
+// the second. The writes are then carried out on the image, which must end
+// in the planned configuration. On the way no field may be written more
+// than twice (parked, then final), each rise of hclk must be announced by a
+// raise step and each drop followed by a lower step, and no watched signal
+// may leave its limits.
+
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <span>
+#include <vector>
+#if REGISTERS_MODULE
+import stm32h7.H745_H757_clocks;
+#else
+#include "stm32h7/H745_H757_clocks.hpp"
+#endif
+#include "register_image.hpp"
+
+namespace {
+
+/// Address ranges holding the clock registers of the tree.
+constexpr Window windows[] = {
+    {0x50000000, 0x10000},  // DSIHOST
+    {0x58020000, 0x10000},  // RCC, PWR
+};
+
+WindowImage image{windows};
+
+using HS = stm32h7::Signals;
+using Req = clocktree::Requirement<HS>;
+using Step = clocktree::Step<HS>;
+
+constexpr Req from[] = {
+    {HS::rcc_hclk, 100'000'000, 100'000'000},
+    {HS::fdcan_ker_ck, 40'000'000, 40'000'000},
+    {HS::rcc_pclk1, 1, 100'000'000},
+    {HS::rcc_pclk2, 1, 100'000'000},
+    {HS::rcc_pclk3, 1, 100'000'000},
+    {HS::rcc_pclk4, 1, 100'000'000},
+};
+
+constexpr Req to[] = {
+    {HS::rcc_hclk, 240'000'000, 240'000'000},
+    {HS::sdmmc_ker_ck, 200'000'000, 400'000'000},
+    {HS::usart16_ker_ck, 64'000'000, 64'000'000},
+    {HS::fdcan_ker_ck, 80'000'000, 80'000'000},
+    {HS::rcc_pclk1, 1, 120'000'000},
+    {HS::rcc_pclk2, 1, 120'000'000},
+    {HS::rcc_pclk3, 1, 120'000'000},
+    {HS::rcc_pclk4, 1, 120'000'000},
+};
+
+constexpr char const* action_names[] = {"write", "stop-pll", "start-pll", "raise", "lower"};
+
+constexpr size_t num_field_uses = std::size(stm32h7::Clocks::field_uses);
+
+bool check(bool ok, char const* what, unsigned n) {
+    if (!ok)
+        std::printf("failed at step %u: %s\n", n, what);
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    image.fill(1);
+    using CT = clocktree::ClockTree<stm32h7::Clocks, clocktree::RegisterImage>;
+    CT ct{clocktree::RegisterImage{image.regions}, stm32h7::Clocks::State{.freqHSE = 25'000'000, .freqLSE = 32768}};
+
+    CT::Plan start, target;
+    if (!ct.plan(from, start)) {
+        std::printf("no plan for the start configuration\n");
+        return 1;
+    }
+    for (auto& s : start)
+        image.write(s);
+    if (!ct.plan(to, target)) {
+        std::printf("no plan for the target configuration\n");
+        return 1;
+    }
+
+    HS const watch[] = {HS::rcc_hclk};
+    static CT::Sequence seq;
+    if (!ct.sequence(target, watch, seq)) {
+        std::printf("no safe sequence found\n");
+        return 1;
+    }
+    std::printf("%u steps from hclk %u Hz to %u Hz\n", seq.count, ct.getFrequency(HS::rcc_hclk),
+                ct.evaluateWith(target, HS::rcc_hclk));
+
+    bool ok = true;
+    unsigned writes[num_field_uses] = {};
+    auto hclk_limits = stm32h7::Clocks::limits[size_t(HS::rcc_hclk)];
+    uint32_t hclk = ct.getFrequency(HS::rcc_hclk), raised = 0;
+    for (unsigned n = 0; n < seq.count; ++n) {
+        auto& step = seq.steps[n];
+        std::printf("%-9s signal %4u %10u Hz", action_names[int(step.action)], unsigned(step.signal),
+                    step.frequency);
+        if (step.action == Step::Action::Raise && step.signal == HS::rcc_hclk)
+            raised = step.frequency;
+        if (step.action != Step::Action::Write) {
+            std::printf("\n");
+            continue;
+        }
+        std::printf("  [%08lx] mask %08x value %08x\n", (unsigned long)step.setting.addr,
+                    step.setting.mask, step.setting.value);
+        image.write(step.setting);
+
+        for (size_t i = 0; i < num_field_uses; ++i) {
+            auto& use = stm32h7::Clocks::field_uses[i];
+            if (stm32h7::Clocks::register_base + 4 * use.word_offset == step.setting.addr
+                && (use.mask & step.setting.mask))
+                ok &= check(++writes[i] <= 2, "field written more than twice", n);
+        }
+        uint32_t f = ct.getFrequency(HS::rcc_hclk);
+        if (f > hclk)
+            ok &= check(raised == f, "hclk rises without a raise step", n);
+        if (f < hclk) {
+            Step const* next = n + 1 < seq.count ? &seq.steps[n + 1] : nullptr;
+            ok &= check(next && next->action == Step::Action::Lower && next->signal == HS::rcc_hclk
+                        && next->frequency == f, "hclk drops without a lower step", n);
+        }
+        ok &= check(f >= hclk_limits.min && f <= hclk_limits.max, "hclk outside its limits", n);
+        hclk = f;
+        raised = 0;
+    }
+
+    for (auto& req : to) {
+        uint32_t f = ct.getFrequency(req.signal);
+        if (f < req.min || f > req.max) {
+            std::printf("signal %u ends at %u Hz\n", unsigned(req.signal), f);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -1,6 +1,8 @@
 // test for soc-data
 
+#include <array>
 #include <cstdint>
+#include <iterator>
 #if REGISTERS_MODULE
 // The chip module imports peripherals but does not re-export them, so any
 // peripheral namespace named below in `using namespace ...` must be imported
@@ -8,17 +10,152 @@
 import stm32h7.DMA;
 import stm32h7.MDMA;
 import stm32h7.STM32H757_CM7;
+import stm32h7.H745_H757_clocks;
+import stm32f4.GPIO;
+import stm32f4.STM32F407;
 import microchip.ATSAME70Q21B;
 import microchip.SAM_Gen1_clocks;
+import rp2040.DMA;
+import rp2040.RP2040;
+import rp2040.RP2040_clocks;
+import lpc8.LPC86x_clocks;
 #else
 #include "stm32h7/STM32H757_CM7.hpp"
+#include "stm32h7/H745_H757_clocks.hpp"
+#include "stm32f4/STM32F407.hpp"
 #include "microchip/ATSAME70Q21B.hpp"
 #include "microchip/SAM_Gen1_clocks.hpp"
+#include "rp2040/RP2040.hpp"
+#include "rp2040/RP2040_clocks.hpp"
+#include "lpc8/LPC86x_clocks.hpp"
 #endif
 
 using namespace stm32h7::DMA;
 using namespace stm32h7::MDMA;
 
+// Clock frequencies of a fixed boot configuration, evaluated at compile time
+// from a register image: main crystal selected in CKGR_MOR, MCK = MAINCK.
+constexpr std::array<uint32_t, 0x40> pmc_image = [] {
+    std::array<uint32_t, 0x40> r{};
+    r[0x20 / 4] = (1u << 24) | 1;
+    r[0x30 / 4] = 1;
+    return r;
+}();
+constexpr clocktree::RegisterImage::Region pmc_regions[] = {{0x400E0600, pmc_image}};
+constexpr clocktree::ClockTree<microchip::Clocks, clocktree::RegisterImage> boot_clocks{
+    clocktree::RegisterImage{pmc_regions}, microchip::Clocks::State{.stateMAIN_XTAL = 12'000'000}};
+static_assert(boot_clocks.getFrequency(microchip::Signals::mck) == 12'000'000);
+static_assert(boot_clocks.getFrequency<microchip::Signals::hclk>() == 12'000'000);
+
+// The same in Q32.32 fixed point, rounded only at the queried signal.
+constexpr clocktree::ClockTree<microchip::Clocks, clocktree::RegisterImage, clocktree::Q32_32> boot_clocks_q32{
+    clocktree::RegisterImage{pmc_regions}, microchip::Clocks::State{.stateMAIN_XTAL = 12'000'000}};
+static_assert(boot_clocks_q32.getExactFrequency(microchip::Signals::mck) == uint64_t(12'000'000) << 32);
+static_assert(boot_clocks_q32.getFrequency<microchip::Signals::hclk>() == 12'000'000);
+
+// A fractional PLL followed by a divider: HSI 64 MHz / DIVM2 4 = 16 MHz into
+// PLL2 with DIVN2 = 25 and FRACN2 = 1, i.e. 400'001'953.125 Hz, and DIVP2 = 2
+// gives 200'000'976.5625 Hz. Whole Hz truncate it at the PLL and the divider,
+// Q32.32 keeps the fraction and rounds once.
+constexpr std::array<uint32_t, 0x10> rcc_image = [] {
+    std::array<uint32_t, 0x10> r{};
+    r[0x00 / 4] = 1;                    // CR: HSION, HSIDIV = /1
+    r[0x28 / 4] = 4u << 12;             // PLLCKSELR: PLLSRC = HSI, DIVM2 = 4
+    r[0x38 / 4] = (1u << 9) | 24;       // PLL2DIVR: DIVP2 = /2, DIVN2 = 25
+    r[0x3C / 4] = 1u << 3;              // PLL2FRACR: FRACN2 = 1
+    return r;
+}();
+constexpr clocktree::RegisterImage::Region rcc_regions[] = {{0x58024400, rcc_image}};
+constexpr clocktree::ClockTree<stm32h7::Clocks, clocktree::RegisterImage> pll2_clocks{
+    clocktree::RegisterImage{rcc_regions}, stm32h7::Clocks::State{}};
+constexpr clocktree::ClockTree<stm32h7::Clocks, clocktree::RegisterImage, clocktree::Q32_32> pll2_clocks_q32{
+    clocktree::RegisterImage{rcc_regions}, stm32h7::Clocks::State{}};
+static_assert(pll2_clocks.getFrequency(stm32h7::Signals::pll2_p_raw) == 200'000'976);
+static_assert(pll2_clocks_q32.getFrequency(stm32h7::Signals::pll2_p_raw) == 200'000'977);
+static_assert(pll2_clocks_q32.getExactFrequency(stm32h7::Signals::pll2_p_raw)
+              == (uint64_t(200'000'976) << 32) + (uint64_t(9) << 28));    // .5625 Hz
+
+// Fractional dividers of both forms, read from a register image at compile
+// time. The RP2040's clk_sys runs from XOSC through CLK_REF (INT = 1), and
+// CLK_SYS with INT = 2, FRAC = 0x80 divides by 2.5, with INT = 0 by 2^16.
+constexpr std::array<uint32_t, 0x11> rp_clocks_image(uint32_t sys_div) {
+    std::array<uint32_t, 0x11> r{};
+    r[0x30 / 4] = 2;                    // CLK_REF_CTRL: SRC = XOSC
+    r[0x34 / 4] = 1u << 8;              // CLK_REF_DIV: INT = 1
+    r[0x40 / 4] = sys_div;              // CLK_SYS_DIV
+    return r;
+}
+constexpr auto rp_sys_div_2_5 = rp_clocks_image((2u << 8) | 0x80);    // INT = 2, FRAC = 0x80
+constexpr auto rp_sys_div_max = rp_clocks_image(0);                   // INT = 0, FRAC = 0
+constexpr uint32_t rp_xosc_image[] = {0xFABu << 12};    // XOSC CTRL: ENABLE
+constexpr clocktree::RegisterImage::Region rp_regions[] = {{0x40008000, rp_sys_div_2_5}, {0x40024000, rp_xosc_image}};
+constexpr clocktree::RegisterImage::Region rp_regions_max[] = {{0x40008000, rp_sys_div_max}, {0x40024000, rp_xosc_image}};
+constexpr clocktree::ClockTree<rp2040::Clocks, clocktree::RegisterImage> rp_clocks{clocktree::RegisterImage{rp_regions}};
+constexpr clocktree::ClockTree<rp2040::Clocks, clocktree::RegisterImage> rp_clocks_max{clocktree::RegisterImage{rp_regions_max}};
+static_assert(rp_clocks.getFrequency(rp2040::Signals::clk_ref) == 12'000'000);
+static_assert(rp_clocks.getFrequency(rp2040::Signals::clk_sys) == 4'800'000);
+static_assert(rp_clocks_max.getFrequency(rp2040::Signals::clk_sys) == 12'000'000 / 65536);
+
+// The LPC86x's FRG0 with MULT = 128, DIV = 255 divides by 1 + 128 / 256.
+constexpr uint32_t lpc_frg0_image[] = {255, 128};       // FRG0DIV, FRG0MULT
+constexpr clocktree::RegisterImage::Region lpc_regions[] = {{0x400480D0, lpc_frg0_image}};
+constexpr auto frg0_freq(uint32_t in_freq) {
+    lpc8::Clocks clocks{lpc8::Clocks::State{}};
+    clocktree::RegisterImage image{lpc_regions};
+    clocktree::DirectContext<lpc8::Clocks::Id, lpc8::Clocks::register_base, clocktree::RegisterImage> ctx{clocks, image};
+    return clocktree::frac_div_freq(lpc8::Clocks::frac_div_descs[0], in_freq, ctx);
+}
+static_assert(frg0_freq(12'000'000) == 8'000'000);
+
+// Masks of a read-modify-write, computed at compile time.
+static_assert(HwReg<C_CR>::masks([](auto &cr) { cr.EN = 1; cr.PL = 2; }).bits == 0x81);
+static_assert(HwReg<C_CR>::masks([](auto &cr) { cr.EN = 1; cr.PL = 2; }).keep == ~0xC1u);
+
+// Reset values from the model.
+static_assert(S_FCR::resetValue == 0x21);
+
+// Side effects from the model: write-1-to-clear error flags next to plain
+// fields, and a read-to-clear field that is not plain.
+static_assert(rp2040::DMA::CH0_CTRL_TRIG::sideEffects.oneToClear == 0x6000'0000);
+static_assert(rp2040::DMA::CH0_CTRL_TRIG::sideEffects.plain == 0xFF'FFFF);
+static_assert(HwReg<rp2040::DMA::CH0_CTRL_TRIG>::clearValue(1u << 30) == 1u << 30);
+static_assert(HwReg<rp2040::DMA::INTR>::clearValue(0x8) == 0x8);
+static_assert(stm32h7::DFSDM::FLT_EXMIN::sideEffects.onRead == 0xFFFF'FF00);
+static_assert(stm32h7::DFSDM::FLT_EXMIN::sideEffects.plain == 0);
+
+// Registers with side effects have no modify().
+template<typename R> concept Modifiable = requires(HwReg<R> volatile &r) { r.modify([](auto &) {}); };
+static_assert(Modifiable<C_CR>);
+static_assert(!Modifiable<rp2040::DMA::CH0_CTRL_TRIG>);
+static_assert(!Modifiable<rp2040::DMA::INTR>);
+
+// Bit-band alias addresses of Cortex-M3/M4 (the H7's CM7 core has none).
+static_assert(BitBand::alias(0x2000'0000, 3) == 0x2200'000C);
+static_assert(BitBand::alias(0x200F'FFFF, 0) == 0x23FF'FFE0);
+static_assert(BitBand::alias(0x4002'0014, 5) == 0x4240'0294);
+static_assert(BitBand::covers(0x4000'4400) && !BitBand::covers(0x5802'0000));
+static_assert(!stm32h7::i_DMA1.bitBand);
+static_assert(stm32f4::i_GPIOA.bitBand);
+
+// Atomic access aliases, set by the RP2040 chip header except for the
+// instances it excludes, like SIO (the H7 has none).
+static_assert(rp2040::i_DMA.aliases.toggle == 0x1000);
+static_assert(rp2040::i_DMA.aliases.set == 0x2000 && rp2040::i_DMA.aliases.clear == 0x3000);
+static_assert(rp2040::i_SIO.aliases.set == 0);
+static_assert(stm32h7::i_DMA1.aliases.set == 0);
+
+// PLL settings for a fixed configuration, found at compile time.
+static_assert(clocktree::ClockTree<microchip::Clocks>::solvePll(
+    microchip::Signals::pllack, 12'000'000, 300'000'000).frequency == 300'000'000);
+
+// The same PLL without VCO limits, as generated for `vco: unlimited`.
+constexpr auto pllack_unlimited = [] {
+    auto p = microchip::Clocks::pll_paths[0];
+    p.vco_freq = {0, 0xFFFFFFFF};
+    return p;
+}();
+static_assert(clocktree::solve_pll(pllack_unlimited, 12'000'000, 300'000'000).frequency == 300'000'000);
+
 int main() {
     auto &mdma = *stm32h7::i_MDMA.registers;    // MDMA register set
     auto &dma = *stm32h7::i_DMA1.registers;     // DMA register set
@@ -33,6 +170,23 @@ int main() {
     auto ma1 = get(dma.S[1].M1AR).M1A;          // dto.
     b.EN = 1;                                   // modify field in bitfield struct
     mdma.C[6].CR = b;                           // write back entire bitfield struct to register
+    mdma.C[6].CR.modify([](auto &cr) {          // one read and one write, changing two fields
+        cr.EN = 1;
+        cr.PL = 2;
+    });
+    dma.S[2].FCR.write_from_reset([](auto &fcr) {   // one write, other fields at their reset values
+        fcr.DMDIS = 1;
+    });
+
+    auto &rp_dma = *rp2040::i_DMA.registers;    // RP2040 peripheral with atomic aliases
+    rp_dma.INTR.set_bits<rp2040::i_DMA.aliases>(1u << 3);   // one store each, to the set, clear and XOR alias
+    rp_dma.INTR.clear_bits<rp2040::i_DMA.aliases>(1u << 3);
+    rp_dma.INTR.toggle_bits<rp2040::i_DMA.aliases>(1u << 3);
+    rp_dma.INTR.clear(1u << 3);                 // only flags: a single store
+    rp_dma.CH0_CTRL_TRIG.clear(rp2040::DMA::CH0_CTRL_TRIG{.WRITE_ERROR = 1});  // plain fields read and written back
+
+    auto &gpio = *stm32f4::i_GPIOA.registers;   // Cortex-M4 peripheral in the bit-band region
+    gpio.ODR.bit_band<stm32f4::i_GPIOA.bitBand>([](auto &odr) { odr.OD5 = 1; }) = true;   // one store to 0x42400294
 
     // Exercise the clock-tree code path: instantiate the SAM_Gen1 tree and
     // query a frequency, with the external crystal frequencies supplied via
@@ -43,4 +197,79 @@ int main() {
     }};
     volatile uint32_t mck = ct.getFrequency(microchip::Signals::mck);
     (void)mck;
+
+    // Cached variant: repeated queries are served from RAM until invalidated.
+    clocktree::CachedClockTree<microchip::Clocks> cct{microchip::Clocks::State{
+        .stateXTAL32K = 32768,
+        .stateMAIN_XTAL = 12'000'000,
+    }};
+    volatile uint32_t hclk = cct.getFrequency(microchip::Signals::hclk);
+    cct.invalidate();
+    hclk = cct.getFrequency(microchip::Signals::hclk);
+    (void)hclk;
+
+    // Whole-tree evaluation in a single forward sweep.
+    uint32_t all[clocktree::ClockTree<microchip::Clocks>::num_signals];
+    cct.evaluateAll(all);
+
+    // Several signals in one query, sharing the common path.
+    microchip::Signals const sigs[] = {
+        microchip::Signals::periph_clk_usart0,
+        microchip::Signals::periph_clk_spi0,
+        microchip::Signals::pck4,
+    };
+    uint32_t freqs[std::size(sigs)];
+    ct.getFrequencies(sigs, freqs);
+
+    // Signal fixed at compile time: the path is unrolled into straight-line code.
+    volatile uint32_t usart0 = ct.getFrequency<microchip::Signals::periph_clk_usart0>();
+    (void)usart0;
+
+    // Frequency-change notification: after writing PMC_MCKR, only the
+    // subscribers downstream of the written fields are re-evaluated.
+    clocktree::Subscription<microchip::Signals> usart_clk{
+        microchip::Signals::periph_clk_usart0,
+        [](auto& sub, uint32_t old_freq) { (void)old_freq; },
+    };
+    cct.subscribe(usart_clk);
+    cct.update(0x400E0630, 0x00000300);
+    cct.unsubscribe(usart_clk);
+
+    // PLL settings for a target frequency, from the current input frequency.
+    volatile auto plla = ct.solvePll(microchip::Signals::pllack, 300'000'000);
+    (void)plla;
+
+    // Register settings for several requirements at once, searched over the
+    // muxes, dividers and PLLs on the way.
+    clocktree::Requirement<microchip::Signals> const reqs[] = {
+        {microchip::Signals::mck, 150'000'000, 150'000'000},
+        {microchip::Signals::usb_48m, 48'000'000, 48'000'000},
+    };
+    clocktree::ClockTree<microchip::Clocks>::Plan plan;
+    volatile bool planned = ct.plan(reqs, plan);
+    (void)planned;
+
+    // Datasheet limit check of the whole tree in one sweep.
+    clocktree::Violation<microchip::Signals> violations[4];
+    volatile size_t num_violations = ct.audit(violations);
+    (void)num_violations;
+
+    // Oscillators and PLLs still needed by a running clock.
+    auto active = ct.activeClocks();
+    volatile bool plla_needed = active.contains(microchip::Signals::pllack);
+    (void)plla_needed;
+
+    // What-if evaluation: MCK with PMC_MCKR.PRES = 1 (divide by 2), and the
+    // found plan, without writing the registers.
+    volatile uint32_t mck_div2 = ct.evaluateWith({{0x400E0630, 0x70, 0x10}}, microchip::Signals::mck);
+    volatile uint32_t mck_planned = ct.evaluateWith(plan, microchip::Signals::mck);
+    (void)mck_div2;
+    (void)mck_planned;
+
+    // Safe order of the writes towards the plan, with the steps around
+    // changes of MCK, e.g. for the flash wait states.
+    microchip::Signals const watch[] = {microchip::Signals::mck};
+    static clocktree::ClockTree<microchip::Clocks>::Sequence seq;
+    volatile bool sequenced = ct.sequence(plan, watch, seq);
+    (void)sequenced;
 }
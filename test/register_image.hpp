@@ -0,0 +1,48 @@
+// pseudo-random register image for the host clock-tree tests
+//
+// Include after the clock-tree headers or module imports, which declare
+// clocktree::RegisterImage.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Address range holding clock registers.
+struct Window { uintptr_t addr; size_t size; };
+
+/// Register contents of N address windows in ordinary memory, handed to the
+/// RegisterImage backend as `regions`.
+template<size_t N> struct WindowImage {
+    Window const (&windows)[N];
+    std::vector<uint32_t> words[N];
+    clocktree::RegisterImage::Region regions[N];
+
+    explicit WindowImage(Window const (&w)[N]) : windows(w) {}
+
+    /// Fill every word with a hash of its address and `seed`.
+    void fill(uint32_t seed) {
+        for (size_t n = 0; n < N; ++n) {
+            auto& w = windows[n];
+            words[n].resize(w.size / 4);
+            for (size_t i = 0; i < w.size / 4; ++i) {
+                uint32_t x = uint32_t(w.addr + 4 * i) ^ seed;
+                x ^= x >> 16; x *= 0x7feb352d;
+                x ^= x >> 15; x *= 0x846ca68b;
+                words[n][i] = x ^ (x >> 16);
+            }
+            regions[n] = {w.addr, words[n]};
+        }
+    }
+
+    /// Carry out a register write on the image.
+    void write(clocktree::RegisterSetting const& s) {
+        for (size_t n = 0; n < N; ++n) {
+            if (s.addr >= windows[n].addr && s.addr < windows[n].addr + windows[n].size) {
+                uint32_t& w = words[n][(s.addr - windows[n].addr) / 4];
+                w = (w & ~s.mask) | s.value;
+            }
+        }
+    }
+};